@@ -0,0 +1,91 @@
+#include <benchmark/benchmark.h>
+
+#include "ResponseArena.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace speechcenter::recognizer::v1;
+
+namespace {
+
+    std::atomic<int64_t> allocations{0};
+
+    std::string buildSerializedResult(int words) {
+        RecognitionStreamingResponse response;
+        auto result = response.mutable_result();
+        result->set_is_final(true);
+        result->set_duration(words * 0.4f);
+        auto alternative = result->add_alternatives();
+        alternative->set_confidence(0.93f);
+        std::string transcript;
+        for (int i = 0; i < words; ++i) {
+            auto word = alternative->add_words();
+            word->set_word("palabra" + std::to_string(i));
+            word->set_start_time(i * 0.4f);
+            word->set_end_time(i * 0.4f + 0.35f);
+            word->set_confidence(0.9f);
+            word->set_speaker_id(i % 2);
+            transcript += word->word() + " ";
+        }
+        alternative->set_transcript(transcript);
+        return response.SerializeAsString();
+    }
+
+    float consume(const RecognitionAlternative &alternative) {
+        return alternative.words(0).start_time() + alternative.words(alternative.words_size() - 1).end_time() +
+               static_cast<float>(alternative.transcript().size());
+    }
+
+    void reportAllocations(benchmark::State &state, int64_t before) {
+        state.counters["allocs/result"] = benchmark::Counter(
+                static_cast<double>(allocations - before) / static_cast<double>(state.iterations()));
+    }
+
+}
+
+void *operator new(std::size_t size) {
+    ++allocations;
+    if (void *pointer = std::malloc(size))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+// Previous read loop: a reused heap message plus a copy of the first alternative.
+static void BM_HeapResponseWithCopy(benchmark::State &state) {
+    const auto serialized = buildSerializedResult(static_cast<int>(state.range(0)));
+    RecognitionStreamingResponse response;
+    const auto before = allocations.load();
+    for (auto _: state) {
+        response.ParseFromString(serialized);
+        RecognitionAlternative firstAlternative = response.result().alternatives().Get(0);
+        benchmark::DoNotOptimize(consume(firstAlternative));
+    }
+    reportAllocations(state, before);
+}
+
+static void BM_ArenaResponseByReference(benchmark::State &state) {
+    const auto serialized = buildSerializedResult(static_cast<int>(state.range(0)));
+    ResponseArena arena;
+    const auto before = allocations.load();
+    for (auto _: state) {
+        auto response = arena.next();
+        response->ParseFromString(serialized);
+        benchmark::DoNotOptimize(consume(response->result().alternatives(0)));
+    }
+    reportAllocations(state, before);
+}
+
+BENCHMARK(BM_HeapResponseWithCopy)->Arg(5)->Arg(50)->Arg(500);
+BENCHMARK(BM_ArenaResponseByReference)->Arg(5)->Arg(50)->Arg(500);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,262 @@
+#include <benchmark/benchmark.h>
+
+#include "SessionCapture.h"
+#include "StandInServer.h"
+#include "TransportProfile.h"
+#include "WireFormat.h"
+
+#include <grpcpp/create_channel.h>
+#include <grpcpp/security/credentials.h>
+
+#include <arpa/inet.h>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace speechcenter::recognizer::v1;
+
+namespace {
+
+    /*
+     * TCP proxy to a local port that emulates a network link: every byte arrives a one-way delay after it was
+     * sent, and no sooner than the link rate allows.
+     */
+    class EmulatedLink {
+    public:
+        EmulatedLink(int targetPort, std::chrono::microseconds oneWay, double bytesPerSecond) :
+                targetPort(targetPort), oneWay(oneWay), bytesPerSecond(bytesPerSecond) {
+            listener = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in address = loopback(0);
+            socklen_t length = sizeof(address);
+            if (bind(listener, reinterpret_cast<sockaddr *>(&address), length) != 0 || ::listen(listener, 16) != 0 ||
+                getsockname(listener, reinterpret_cast<sockaddr *>(&address), &length) != 0)
+                throw std::runtime_error("Unable to listen for the emulated link");
+            port = ntohs(address.sin_port);
+            acceptor = std::thread([this] { accept(); });
+        }
+
+        ~EmulatedLink() {
+            shutdown(listener, SHUT_RDWR);
+            acceptor.join();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (auto socket: sockets)
+                    shutdown(socket, SHUT_RDWR);
+            }
+            for (auto &pump: pumps)
+                pump.join();
+            close(listener);
+            for (auto socket: sockets)
+                close(socket);
+        }
+
+        int getPort() const { return port; }
+
+    private:
+        struct Segment {
+            std::chrono::steady_clock::time_point arrival;
+            std::string bytes;// empty once the sender closed
+        };
+
+        static sockaddr_in loopback(int port) {
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            address.sin_port = htons(static_cast<uint16_t>(port));
+            return address;
+        }
+
+        void accept() {
+            while (true) {
+                int client = ::accept(listener, nullptr, nullptr);
+                if (client < 0)
+                    return;
+                int server = socket(AF_INET, SOCK_STREAM, 0);
+                sockaddr_in address = loopback(targetPort);
+                if (connect(server, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+                    close(client);
+                    close(server);
+                    continue;
+                }
+                int noDelay = 1;
+                setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+                setsockopt(server, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+                std::lock_guard<std::mutex> lock(mutex);
+                sockets.push_back(client);
+                sockets.push_back(server);
+                pumps.emplace_back([this, client, server] { pipe(client, server); });
+                pumps.emplace_back([this, client, server] { pipe(server, client); });
+            }
+        }
+
+        void pipe(int from, int to) {
+            std::mutex queueMutex;
+            std::condition_variable queued;
+            std::deque<Segment> queue;
+            std::thread deliverer([&] {
+                while (true) {
+                    Segment segment;
+                    {
+                        std::unique_lock<std::mutex> lock(queueMutex);
+                        queued.wait(lock, [&] { return !queue.empty(); });
+                        segment = std::move(queue.front());
+                        queue.pop_front();
+                    }
+                    std::this_thread::sleep_until(segment.arrival);
+                    if (segment.bytes.empty()) {
+                        shutdown(to, SHUT_WR);
+                        return;
+                    }
+                    for (std::size_t sent = 0; sent < segment.bytes.size();) {
+                        auto written = send(to, segment.bytes.data() + sent, segment.bytes.size() - sent, MSG_NOSIGNAL);
+                        if (written <= 0)
+                            break;
+                        sent += static_cast<std::size_t>(written);
+                    }
+                }
+            });
+            auto linkFree = std::chrono::steady_clock::now();
+            char buffer[16384];
+            while (true) {
+                auto received = recv(from, buffer, sizeof(buffer), 0);
+                auto now = std::chrono::steady_clock::now();
+                Segment segment{now + oneWay, received > 0 ? std::string(buffer, received) : std::string()};
+                if (bytesPerSecond > 0 && received > 0) {
+                    // Bytes queue behind the previous ones for as long as the link takes to carry them.
+                    linkFree = std::max(linkFree, now) + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                            std::chrono::duration<double>(received / bytesPerSecond));
+                    segment.arrival = linkFree + oneWay;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(queueMutex);
+                    queue.push_back(std::move(segment));
+                }
+                queued.notify_one();
+                if (received <= 0)
+                    break;
+            }
+            deliverer.join();
+        }
+
+        const int targetPort;
+        const std::chrono::microseconds oneWay;
+        const double bytesPerSecond;
+        int listener;
+        int port;
+        std::thread acceptor;
+        std::mutex mutex;
+        std::vector<int> sockets;
+        std::list<std::thread> pumps;
+    };
+
+    struct Link {
+        const char *name;
+        std::chrono::microseconds oneWay;
+        double bytesPerSecond;// 0 for unlimited
+    };
+
+    const Link links[] = {{"lan", std::chrono::microseconds(100), 0},
+                          {"wan", std::chrono::milliseconds(40), 100e6 / 8},
+                          {"low-bandwidth", std::chrono::milliseconds(75), 2e6 / 8}};
+
+    constexpr std::size_t chunkBytes = 40000;// 2.5 s at 8 kHz, as the client sends a file
+    constexpr std::size_t chunks = 24;// one minute of audio
+
+    // A voice-like signal: two formants that come and go with the syllables, over some noise.
+    std::shared_ptr<const std::vector<int16_t>> buildSpeech() {
+        auto samples = std::make_shared<std::vector<int16_t>>(chunks * chunkBytes / sizeof(int16_t));
+        uint32_t noise = 1;
+        for (std::size_t i = 0; i < samples->size(); ++i) {
+            double t = static_cast<double>(i) / 8000;
+            double envelope = std::max(0.0, std::sin(2 * M_PI * 4 * t));
+            noise = noise * 1664525 + 1013904223;
+            double value = envelope * (6000 * std::sin(2 * M_PI * 700 * t) + 3000 * std::sin(2 * M_PI * 1200 * t)) +
+                           static_cast<int>(noise >> 24) - 128;
+            (*samples)[i] = static_cast<int16_t>(value);
+        }
+        return samples;
+    }
+
+    // The stand-in answers with one final result once all the audio has arrived.
+    const std::string &captureWholeStream() {
+        static const std::string path = "bench_transportProfile.capture";
+        static const bool written = [] {
+            SessionRecorder recorder(path);
+            RecognitionStreamingRequest config;
+            config.mutable_config()->mutable_parameters()->set_language("en-US");
+            recorder.record(config);
+            RecognitionStreamingRequest audio;
+            audio.set_audio(std::string(chunkBytes, '\0'));
+            for (std::size_t i = 0; i < chunks; ++i)
+                recorder.record(audio);
+            RecognitionStreamingResponse response;
+            response.mutable_result()->set_is_final(true);
+            response.mutable_result()->add_alternatives()->set_transcript("done");
+            recorder.record(response);
+            return true;
+        }();
+        benchmark::DoNotOptimize(written);
+        return path;
+    }
+
+}
+
+// Streams a minute of audio as fast as the link allows and waits for the final result.
+static void BM_TransportProfile(benchmark::State &state) {
+    const auto &profile = TransportProfile::byName(TransportProfile::names()[state.range(0)]);
+    const auto &link = links[state.range(1)];
+    state.SetLabel(profile.name + " profile over a " + link.name + " link");
+
+    SessionCapture capture(captureWholeStream());
+    StandInServer server(capture, 0);
+    EmulatedLink emulated(server.start("localhost:0"), link.oneWay, link.bytesPerSecond);
+    grpc::ChannelArguments arguments;
+    profile.apply(arguments);
+    auto channel = grpc::CreateCustomChannel("127.0.0.1:" + std::to_string(emulated.getPort()),
+                                             grpc::InsecureChannelCredentials(), arguments);
+
+    const auto samples = buildSpeech();
+    RecognitionStreamingRequest configRequest;
+    configRequest.mutable_config()->mutable_parameters()->set_language("en-US");
+    const auto config = wire::serialize(configRequest);
+    std::vector<wire::Frame> audio;
+    const auto bytes = reinterpret_cast<const char *>(samples->data());
+    for (std::size_t i = 0; i < chunks; ++i)
+        audio.push_back(wire::audioFrame(bytes + i * chunkBytes, chunkBytes, samples));
+
+    for (auto _: state) {
+        grpc::ClientContext context;
+        profile.apply(context);
+        auto stream = wire::openRecognitionStream(channel, &context);
+        grpc::WriteOptions head;
+        if (profile.coalesceHead)
+            head.set_buffer_hint();
+        stream->Write(config.buffer, head);
+        for (const auto &frame: audio)
+            stream->Write(frame.buffer);
+        stream->WritesDone();
+        grpc::ByteBuffer response;
+        while (stream->Read(&response))
+            benchmark::DoNotOptimize(response.Length());
+        if (!stream->Finish().ok())
+            state.SkipWithError("Stream failed");
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * chunks * chunkBytes));
+    server.shutdown();
+}
+
+// CPU time is of the whole process, so it includes the stand-in server decompressing the audio.
+BENCHMARK(BM_TransportProfile)
+        ->ArgsProduct({{0, 1, 2, 3}, {0, 1, 2}})
+        ->MeasureProcessCPUTime()
+        ->UseRealTime()
+        ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,59 @@
+#include <benchmark/benchmark.h>
+
+#include "WireFormat.h"
+
+#include <grpcpp/impl/codegen/proto_utils.h>
+
+#include <vector>
+
+using namespace speechcenter::recognizer::v1;
+
+typedef RecognitionStreamingRequest Request;
+
+namespace {
+
+    std::shared_ptr<const std::vector<int16_t>> buildSamples(std::size_t bytes) {
+        auto samples = std::make_shared<std::vector<int16_t>>(bytes / sizeof(int16_t));
+        for (std::size_t i = 0; i < samples->size(); ++i)
+            (*samples)[i] = static_cast<int16_t>(i * 31);
+        return samples;
+    }
+
+    void reportBytes(benchmark::State &state) {
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+    }
+
+}
+
+// Previous write path: the chunk copied into a request message, which gRPC serializes again on every write.
+static void BM_ProtobufAudioRequest(benchmark::State &state) {
+    const auto samples = buildSamples(state.range(0));
+    for (auto _: state) {
+        Request request;
+        request.set_audio(samples->data(), samples->size() * sizeof(int16_t));
+        grpc::ByteBuffer buffer;
+        bool ownBuffer;
+        grpc::SerializationTraits<Request>::Serialize(request, &buffer, &ownBuffer);
+        benchmark::DoNotOptimize(buffer.Length());
+    }
+    reportBytes(state);
+}
+
+// Wire frame referencing the samples, which a write only references again.
+static void BM_ZeroCopyAudioFrame(benchmark::State &state) {
+    const auto samples = buildSamples(state.range(0));
+    for (auto _: state) {
+        auto frame = wire::audioFrame(samples->data(), samples->size() * sizeof(int16_t), samples);
+        grpc::ByteBuffer buffer;
+        bool ownBuffer;
+        grpc::SerializationTraits<grpc::ByteBuffer>::Serialize(frame.buffer, &buffer, &ownBuffer);
+        benchmark::DoNotOptimize(buffer.Length());
+    }
+    reportBytes(state);
+}
+
+// 100 ms of 16 kHz audio, as live chunks, and the 2.5 s chunks of a file at 8 kHz.
+BENCHMARK(BM_ProtobufAudioRequest)->Arg(3200)->Arg(40000);
+BENCHMARK(BM_ZeroCopyAudioFrame)->Arg(3200)->Arg(40000);
+
+BENCHMARK_MAIN();
@@ -1,22 +1,31 @@
 #ifndef CLI_CLIENT_AUDIO_H
 #define CLI_CLIENT_AUDIO_H
 
+#include "AudioAnalysis.h"
+#include "Tracing.h"
+
+#include <chrono>
 #include <fstream>
 #include <array>
 #include <vector>
 #include <algorithm>
 #include <cmath>
 #include <memory>
+#include <string>
 
 
 class Audio {
 public:
     Audio(const int16_t *data, int samplingRate, int lengthInFrames);
 
-    Audio(const std::string &audioPath);
+    // Analyzes the samples for the pre-flight report as they are decoded, only if asked to.
+    explicit Audio(const std::string &audioPath, bool analyze = false);
 
     ~Audio();
 
+    // Duration from the file header, without decoding. Zero if the header does not tell.
+    static std::chrono::microseconds probeDuration(const std::string &audioPath);
+
     const int16_t *const getData() const { return data.get(); }
 
     int64_t getSamplingRate() const { return samplingRate; }
@@ -27,6 +36,12 @@ public:
 
     int64_t getBytesPerSamples() const { return sizeof(data[0]); }
 
+    // Pre-flight analysis, computed while the samples were decoded. Empty unless the audio was decoded with it.
+    const AudioReport &getReport() const { return report; }
+
+    // The decoding span, kept until the requests built from the audio take it over.
+    TraceSession &getTrace() const { return trace; }
+
     template<std::size_t chunkLength>
     std::vector<std::array<int16_t, chunkLength> > getAudioChunks() const;
 
@@ -34,6 +49,8 @@ private:
     std::unique_ptr<int16_t[]> data;
     int64_t length{0};
     int64_t samplingRate{0};
+    AudioReport report;
+    mutable TraceSession trace;
 };
 
 template<std::size_t chunkLength>
@@ -0,0 +1,69 @@
+#ifndef CLI_CLIENT_AUDIOANALYSIS_H
+#define CLI_CLIENT_AUDIOANALYSIS_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Pre-flight measures of an audio, to catch inputs that cannot give a transcript before paying for one.
+struct AudioReport {
+    int64_t frames{0};
+    int64_t declaredFrames{0};// by the file header, zero if unknown
+    int64_t sampleRate{0};
+    int channels{1};// interleaved in the samples, which are streamed as mono
+    double rms{-120};// dBFS
+    double peak{-120};// dBFS
+    double clipping{0};// fraction of the samples at full scale
+    double dcOffset{0};// mean sample, as a fraction of full scale
+    double silence{0};// fraction of the 10 ms frames under -50 dBFS
+    double highBand{0};// energy above 5 kHz relative to the whole, in dB; 16 kHz audio only
+    uint32_t bandwidth{0};// Hz, either the Nyquist frequency or 4000 for narrowband content
+
+    // Why the audio is unlikely to be recognized when streamed at the given sample rate; empty if it looks fine.
+    std::vector<std::string> findProblems(uint32_t streamedRate) const;
+
+    static void writeTsvHeader(std::ostream &out);
+
+    void writeTsv(std::ostream &out, const std::string &path, const std::vector<std::string> &problems) const;
+};
+
+/*
+ * Computes an AudioReport in one pass over the samples, block by block as they are decoded, so the samples are
+ * analyzed while still in cache. Every measure is a plain loop over the block that the compiler vectorizes; the
+ * bandwidth is the energy left by a high-pass FIR filter, which is only a resampler's noise floor when 8 kHz audio
+ * was upsampled to 16 kHz.
+ */
+class AudioAnalyzer {
+public:
+    explicit AudioAnalyzer(int64_t sampleRate, int channels = 1);
+
+    void add(const int16_t *samples, std::size_t count);
+
+    AudioReport finish(int64_t declaredFrames) const;
+
+    static constexpr std::size_t taps = 63;
+
+private:
+    void addFrame(const int16_t *samples, std::size_t count);
+
+    void filter(const int16_t *samples, std::size_t count);
+
+    const int64_t sampleRate;
+    const int channels;
+    const std::size_t frameLength;
+    int64_t frames{0};
+    int64_t sum{0};
+    uint64_t squares{0};
+    int32_t peak{0};
+    int64_t clipped{0};
+    std::size_t framePosition{0};
+    uint64_t frameSquares{0};
+    int64_t completeFrames{0};
+    int64_t silentFrames{0};
+    std::vector<float> window;// the last taps - 1 samples, then the block being filtered
+    std::vector<float> highPassed;
+    double highSquares{0};
+};
+
+#endif //CLI_CLIENT_AUDIOANALYSIS_H
@@ -0,0 +1,50 @@
+#ifndef CLI_CLIENT_AUDIOPREFETCHER_H
+#define CLI_CLIENT_AUDIOPREFETCHER_H
+
+#include "Audio.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Decodes a list of audio files in order on a background thread, keeping up to readAhead decoded files ready,
+ * so that decoding the next files overlaps with streaming the current one.
+ */
+class AudioPrefetcher {
+public:
+    // With analyze, every file is also analyzed for the pre-flight report while it is decoded.
+    AudioPrefetcher(const std::vector<std::string> &paths, std::size_t readAhead, bool analyze = false);
+
+    ~AudioPrefetcher();
+
+    bool hasNext() const;
+
+    // Blocks until the next file is decoded and rethrows the error raised while decoding it, if any.
+    std::shared_ptr<const Audio> next();
+
+private:
+    struct Decoded {
+        std::shared_ptr<const Audio> audio;
+        std::exception_ptr error;
+    };
+
+    void decodeLoop();
+
+    const std::vector<std::string> paths;
+    const std::size_t readAhead;
+    const bool analyze;
+    std::size_t consumed{0};
+    std::deque<Decoded> ready;
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    bool stopping{false};
+    std::thread decoder;
+};
+
+#endif //CLI_CLIENT_AUDIOPREFETCHER_H
@@ -0,0 +1,64 @@
+#ifndef CLI_CLIENT_CONCURRENCYLIMITER_H
+#define CLI_CLIENT_CONCURRENCYLIMITER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+/*
+ * Adaptive limit on the number of sessions in flight (AIMD). While the final-result latency of finished sessions stays
+ * within a tolerance of the lowest latency seen, the limit grows by one per limit's worth of successes. Latency above
+ * the tolerance shrinks it a little, and server pushback (RESOURCE_EXHAUSTED, UNAVAILABLE) halves it. Only the first
+ * pushback from sessions started under the same limit counts, so one overload event backs off once.
+ */
+class ConcurrencyLimiter {
+public:
+    enum class Outcome {
+        Success, Overload, Failure
+    };
+
+    struct Ticket {
+        uint64_t epoch;
+    };
+
+    // Called after every acquire and release, one call at a time and outside the limiter's lock.
+    typedef std::function<void(double limit, std::size_t inFlight)> LimitListener;
+
+    explicit ConcurrencyLimiter(std::size_t maxLimit, LimitListener listener = {});
+
+    // Blocks until one more session fits in the current limit.
+    Ticket acquire();
+
+    // latency is the final-result latency of the session, zero when it produced no timed final result.
+    void release(const Ticket &ticket, Outcome outcome, std::chrono::microseconds latency);
+
+    double getLimit() const;
+
+    std::size_t getInFlight() const;
+
+private:
+    static constexpr double latencyTolerance = 1.5;
+    static constexpr double latencyBackoff = 0.9;
+    static constexpr double overloadBackoff = 0.5;
+    // How fast the baseline follows latencies above it, so that a lasting change of the floor is learned.
+    static constexpr double baselineDrift = 0.05;
+
+    std::size_t allowed() const;
+
+    // Hands a snapshot of the state to the listener and unlocks.
+    void publish(std::unique_lock<std::mutex> &lock);
+
+    const double maxLimit;
+    const LimitListener listener;
+    double limit{1};
+    std::size_t inFlight{0};
+    uint64_t epoch{0};
+    double baselineUs{0};
+    mutable std::mutex mutex;
+    std::mutex listenerMutex;
+    std::condition_variable released;
+};
+
+#endif //CLI_CLIENT_CONCURRENCYLIMITER_H
@@ -5,6 +5,7 @@
 #include <string>
 #include <vector>
 #include "Grammar.h"
+#include "Tracing.h"
 
 class Configuration {
 public:
@@ -18,12 +19,33 @@ public:
 
     std::string getAudioPath() const;
 
+    std::vector<std::string> getAudioPaths() const;
+
+    // Priority of each audio path, zero unless given in the audio list.
+    std::vector<int> getAudioPriorities() const;
+
+    std::string getSchedule() const;
+
+    std::string getPreflight() const;
+
+    std::string getPreflightReportPath() const;
+
+    uint32_t getReadAhead() const;
+
     bool hasTopic() const;
 
     std::string getTopic() const;
 
     std::string getHost() const;
 
+    std::vector<std::string> getHosts() const;
+
+    bool getHedging() const;
+
+    uint32_t getProbeInterval() const;
+
+    std::string getTransport() const;
+
     std::string getLanguage() const;
 
     std::string getTokenPath() const;
@@ -48,8 +70,47 @@ public:
 
     std::string getClientSecret()  const;
 
+    std::string getCapturePath() const;
+
+    std::string getTracePath() const;
+
+    std::string getCacheDirectory() const;
+
+    std::string getTranscriptDirectory() const;
+
+    std::string getKeywordsPath() const;
+
+    double getDeadlineFactor() const;
+
+    uint32_t getDeadlineMargin() const;
+
+    std::vector<uint16_t> getRtpPorts() const;
+
+    uint32_t getJitterDelay() const;
+
+    uint32_t getRtpIdleTimeout() const;
+
+    uint32_t getConcurrency() const;
+
+    std::string getMetricsPath() const;
+
+    std::vector<std::string> getCandidateLanguages() const;
+
+    std::vector<std::string> getCandidateTopics() const;
+
+    uint32_t getWarmUp() const;
+
+    std::string getSharedQuota() const;
+
+    uint32_t getQuotaStreams() const;
+
+    double getQuotaAudioRate() const;
+
     void validate_configuration_values();
 
+    // Spans of the parsing, e.g. reading a compiled grammar, for the client to take into its setup trace.
+    TraceSession &getParseTrace() const;
+
 private:
 
     void validate_string_value(const char *name, const std::string &value, const std::vector<std::string> &allowedValues);
@@ -58,7 +119,17 @@ private:
     std::string topic;
     Grammar grammar;
     std::string audioPath;
+    std::vector<std::string> audioPaths;
+    std::vector<int> audioPriorities;
+    uint32_t readAhead;
+    std::string schedule;
+    std::string preflight;
+    std::string preflightReportPath;
     std::string host;
+    std::vector<std::string> hosts;
+    bool hedging;
+    uint32_t probeInterval;
+    std::string transport;
     std::string tokenPath;
     std::string asrVersion;
     uint32_t sampleRate;
@@ -68,9 +139,30 @@ private:
     std::string label;
     std::string clientId;
     std::string clientSecret;
+    std::string capturePath;
+    std::string tracePath;
+    std::string cacheDirectory;
+    std::string transcriptDirectory;
+    std::string keywordsPath;
+    double deadlineFactor;
+    uint32_t deadlineMargin;
+    std::vector<uint16_t> rtpPorts;
+    uint32_t jitterDelay;
+    uint32_t rtpIdleTimeout;
+    uint32_t concurrency;
+    std::string metricsPath;
+    std::vector<std::string> candidateLanguages;
+    std::vector<std::string> candidateTopics;
+    uint32_t warmUp;
+    std::string sharedQuota;
+    uint32_t quotaStreams;
+    double quotaAudioRate;
+    std::shared_ptr<TraceSession> parseTrace = std::make_shared<TraceSession>();// shared by the copies
     std::vector<std::string> allowedTopicValues = {"GENERIC"};
     std::vector<std::string> allowedLanguageValues = {"en-US", "en-GB", "pt-BR", "es", "es-ES", "ca-ES", "es-419", "gl-ES", "tr", "ja", "fr", "fr-CA", "de", "it"};
     std::vector<std::string> allowedAsrVersionValues = {"V1", "V2"};
+    std::vector<std::string> allowedScheduleValues = {"listed", "longest-first"};
+    std::vector<std::string> allowedPreflightValues = {"off", "flag", "skip"};
     
 };
 
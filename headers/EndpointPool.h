@@ -0,0 +1,76 @@
+#ifndef CLI_CLIENT_ENDPOINTPOOL_H
+#define CLI_CLIENT_ENDPOINTPOOL_H
+
+#include <grpcpp/channel.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Endpoint {
+    explicit Endpoint(const std::string &host) : host(host) {}
+
+    const std::string host;
+    std::shared_ptr<grpc::Channel> channel;
+
+    // Guarded by the owning EndpointPool.
+    double rttMs{0};
+    bool measured{false};
+    bool healthy{true};
+    std::chrono::steady_clock::time_point retryAt;// when an unhealthy endpoint is ranked with the healthy ones again
+};
+
+/*
+ * Keeps one channel per configured host together with a smoothed round-trip estimate that is refreshed by a
+ * background prober. The probe measures how long a fresh, unshared connection takes to become READY, which is
+ * the cost a new session pays on that host. The first round of probes, on all the hosts at once, is done before the
+ * pool is used, so the channels need not be waited for when they are created. An endpoint reported unavailable is
+ * healthy again once a probe or a stream succeeds on it, or after retryAfter, so it is not given up on when probing
+ * is disabled.
+ */
+class EndpointPool {
+public:
+    typedef std::function<std::shared_ptr<grpc::Channel>(const std::string &host, bool probe)> ChannelFactory;
+
+    EndpointPool(const std::vector<std::string> &hosts, ChannelFactory channelFactory,
+                 std::chrono::milliseconds probeInterval, std::chrono::milliseconds retryAfter = std::chrono::seconds(30));
+
+    ~EndpointPool();
+
+    // Healthy endpoints ordered by estimated RTT, followed by the unhealthy ones as a last resort.
+    std::vector<std::shared_ptr<Endpoint>> rank() const;
+
+    void reportUnavailable(const std::shared_ptr<Endpoint> &endpoint);
+
+    void reportAvailable(const std::shared_ptr<Endpoint> &endpoint);
+
+private:
+    void probeLoop();
+
+    void probeAll();
+
+    void probe(const std::shared_ptr<Endpoint> &endpoint);
+
+    void update(Endpoint &endpoint, double sampleMs);
+
+    void markUnavailable(Endpoint &endpoint);
+
+    static constexpr double smoothingFactor = 0.3;
+    static constexpr std::chrono::seconds probeTimeout{5};
+
+    std::vector<std::shared_ptr<Endpoint>> endpoints;
+    ChannelFactory channelFactory;
+    std::chrono::milliseconds probeInterval;
+    std::chrono::milliseconds retryAfter;
+    mutable std::mutex mutex;
+    std::condition_variable stopCondition;
+    bool stopping{false};
+    std::thread prober;
+};
+
+#endif //CLI_CLIENT_ENDPOINTPOOL_H
@@ -0,0 +1,25 @@
+#ifndef CLI_CLIENT_G711_H
+#define CLI_CLIENT_G711_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * ITU-T G.711 companding at 8 kHz. The decoders are branch-free so that the compiler turns the loops into SIMD code;
+ * the encoders are only used to produce test traffic.
+ */
+namespace g711 {
+
+    constexpr uint32_t sampleRate = 8000;
+
+    void decodeUlaw(const uint8_t *codes, int16_t *samples, std::size_t count);
+
+    void decodeAlaw(const uint8_t *codes, int16_t *samples, std::size_t count);
+
+    uint8_t encodeUlaw(int16_t sample);
+
+    uint8_t encodeAlaw(int16_t sample);
+
+}
+
+#endif //CLI_CLIENT_G711_H
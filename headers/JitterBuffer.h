@@ -0,0 +1,69 @@
+#ifndef CLI_CLIENT_JITTERBUFFER_H
+#define CLI_CLIENT_JITTERBUFFER_H
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+/*
+ * Puts the decoded frames of one RTP flow back in sequence order. Frames are released as soon as they are next in
+ * sequence; a gap is held open for up to the jitter delay so that reordered packets can still fill it, and is then
+ * given up and concealed by repeating the last frame with a fading gain. Late and duplicated packets are dropped.
+ */
+class JitterBuffer {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Statistics {
+        uint64_t received{0};
+        uint64_t reordered{0};
+        uint64_t duplicates{0};
+        uint64_t late{0};
+        uint64_t concealed{0};
+    };
+
+    explicit JitterBuffer(std::chrono::milliseconds delay);
+
+    void push(uint16_t sequence, std::vector<int16_t> samples, Clock::time_point arrival);
+
+    // Appends to output every frame that can be played at now.
+    void pop(Clock::time_point now, std::vector<int16_t> &output);
+
+    // Appends everything still buffered, concealing the gaps, e.g. when the flow ends.
+    void flush(std::vector<int16_t> &output);
+
+    // When pop() may release more frames, or Clock::time_point::max() if only a new packet can unblock it.
+    Clock::time_point nextRelease() const;
+
+    const Statistics &getStatistics() const;
+
+private:
+    struct Frame {
+        std::vector<int16_t> samples;
+        Clock::time_point arrival;
+    };
+
+    // Sequence jumps larger than this are taken as a restarted sender rather than as lost packets.
+    static constexpr int64_t maxGap = 1000;
+    // Consecutive concealed frames after which only silence is produced.
+    static constexpr int fadeFrames = 4;
+
+    int64_t extend(uint16_t sequence) const;
+
+    void play(Frame &frame, std::vector<int16_t> &output);
+
+    // Fills the frames missing before until, shaped like the last played frame or as frameSize samples of silence.
+    void conceal(int64_t until, std::size_t frameSize, std::vector<int16_t> &output);
+
+    const std::chrono::milliseconds delay;
+    std::map<int64_t, Frame> frames;
+    bool started{false};
+    int64_t next{0};
+    int64_t highest{0};
+    std::vector<int16_t> lastFrame;
+    int lostInRow{0};
+    Statistics statistics;
+};
+
+#endif //CLI_CLIENT_JITTERBUFFER_H
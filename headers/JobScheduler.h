@@ -0,0 +1,41 @@
+#ifndef CLI_CLIENT_JOBSCHEDULER_H
+#define CLI_CLIENT_JOBSCHEDULER_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+/*
+ * Orders the audio files of a run. Since audio is streamed in real time, a recognition takes about as long as its
+ * audio, and a long file started last keeps the run going long after the others are done. Longest processing time
+ * first hands the longest files out first, so the short ones fill the slots up at the end. Files of a higher
+ * priority always go before those of a lower one.
+ */
+class JobScheduler {
+public:
+    enum class Order {
+        Listed,
+        LongestFirst
+    };
+
+    struct Job {
+        std::string path;
+        std::chrono::microseconds duration;// zero when unknown
+        int priority{0};
+    };
+
+    JobScheduler(std::size_t slots, Order order);
+
+    // Stable, so files with the same priority and duration stay in listing order.
+    std::vector<Job> schedule(std::vector<Job> jobs) const;
+
+    // Time to run the jobs in this order, each one started on the first slot that is free. All the slots are taken
+    // to be open from the start, so this is the shortest the run can take.
+    std::chrono::microseconds predictMakespan(const std::vector<Job> &jobs) const;
+
+private:
+    const std::size_t slots;
+    const Order order;
+};
+
+#endif //CLI_CLIENT_JOBSCHEDULER_H
@@ -0,0 +1,89 @@
+#ifndef CLI_CLIENT_KEYWORDSPOTTER_H
+#define CLI_CLIENT_KEYWORDSPOTTER_H
+
+#include "recognition_streaming_response.pb.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Aho-Corasick automaton over the words of a phrase list. Phrases and transcripts are split into words that are
+ * lowercased and stripped of accents, so matching ignores case, accents and punctuation, and a phrase only matches
+ * whole words. Once built it is only read, so one automaton serves every concurrent stream.
+ */
+class KeywordAutomaton {
+public:
+    explicit KeywordAutomaton(const std::vector<std::string> &phrases);
+
+    // One phrase per line; empty lines and lines starting with # are skipped.
+    static std::shared_ptr<const KeywordAutomaton> load(const std::string &path);
+
+    // Lowercase words without accents, split on anything but letters and digits.
+    static std::vector<std::string> tokenize(const std::string &text);
+
+    std::size_t countPhrases() const;
+
+    const std::string &getPhrase(uint32_t phrase) const;
+
+    // Number of words of the phrase.
+    uint32_t getLength(uint32_t phrase) const;
+
+    static constexpr uint32_t root = 0;
+
+    uint32_t step(uint32_t state, const std::string &word) const;
+
+    // Phrases that end with the last word that led to the state.
+    const std::vector<uint32_t> &getMatches(uint32_t state) const;
+
+private:
+    static uint64_t edge(uint32_t state, uint32_t word) { return static_cast<uint64_t>(state) << 32 | word; }
+
+    uint32_t follow(uint32_t state, uint32_t word) const;
+
+    std::unordered_map<std::string, uint32_t> words;
+    std::unordered_map<uint64_t, uint32_t> transitions;
+    std::vector<uint32_t> failures;
+    std::vector<std::vector<uint32_t>> matches;
+    std::vector<std::string> phrases;
+    std::vector<uint32_t> lengths;
+};
+
+/*
+ * Spots the phrases of an automaton in the results of one stream, interim and final, as soon as they arrive.
+ * An interim result revises the whole segment being spoken, so a phrase already reported for the segment is only
+ * reported again if it occurs more times than before. A final result closes the segment.
+ */
+class KeywordSpotter {
+public:
+    struct Hit {
+        std::string phrase;
+        double startTime;// seconds, zero when the result has no word timings
+        double endTime;
+        uint32_t speaker;
+        bool final;
+    };
+
+    typedef std::function<void(const Hit &hit)> HitListener;
+
+    KeywordSpotter(std::shared_ptr<const KeywordAutomaton> automaton, HitListener listener);
+
+    void onResult(const speechcenter::recognizer::v1::RecognitionResult &result);
+
+private:
+    struct Token {
+        std::string word;
+        float startTime;
+        float endTime;
+        uint32_t speaker;
+    };
+
+    const std::shared_ptr<const KeywordAutomaton> automaton;
+    const HitListener listener;
+    std::unordered_map<uint32_t, std::size_t> reported;// occurrences of each phrase in the current segment
+};
+
+#endif //CLI_CLIENT_KEYWORDSPOTTER_H
@@ -0,0 +1,39 @@
+#ifndef CLI_CLIENT_LIVEAUDIO_H
+#define CLI_CLIENT_LIVEAUDIO_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * PCM16 audio produced while it is being recognized, e.g. by a telephony flow. The producer pushes samples as they
+ * arrive and closes the audio at the end; a session pops them in chunks of chunkDuration, so the stream is paced by
+ * the producer rather than by the clock.
+ */
+class LiveAudio {
+public:
+    LiveAudio(uint32_t sampleRate, std::chrono::milliseconds chunkDuration);
+
+    void push(const int16_t *samples, std::size_t count);
+
+    void close();
+
+    // Blocks until a chunk is buffered and moves it into chunk as raw PCM16 bytes. After close() it returns the
+    // remaining samples, then false.
+    bool pop(std::string &chunk);
+
+    uint32_t getSampleRate() const;
+
+private:
+    const uint32_t sampleRate;
+    const std::size_t chunkSamples;
+    std::vector<int16_t> buffered;
+    bool closed{false};
+    std::mutex mutex;
+    std::condition_variable changed;
+};
+
+#endif //CLI_CLIENT_LIVEAUDIO_H
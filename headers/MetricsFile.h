@@ -0,0 +1,31 @@
+#ifndef CLI_CLIENT_METRICSFILE_H
+#define CLI_CLIENT_METRICSFILE_H
+
+#include <map>
+#include <mutex>
+#include <string>
+
+/*
+ * Gauges exported in the Prometheus text format, e.g. for the node_exporter textfile collector. Every write() replaces
+ * the file atomically, so a scraper never reads a partial file.
+ */
+class MetricsFile {
+public:
+    explicit MetricsFile(std::string path);
+
+    void set(const std::string &name, const std::string &help, double value);
+
+    void write() const;
+
+private:
+    struct Gauge {
+        std::string help;
+        double value;
+    };
+
+    const std::string path;
+    std::map<std::string, Gauge> gauges;
+    mutable std::mutex mutex;
+};
+
+#endif //CLI_CLIENT_METRICSFILE_H
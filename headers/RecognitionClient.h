@@ -2,11 +2,20 @@
 #define ASRTEST_RECOGNITIONCLIENT_H
 
 #include "Configuration.h"
+#include "EndpointPool.h"
+#include "RecognitionSession.h"
+#include "SharedQuota.h"
+#include "Tracing.h"
+#include "TransportProfile.h"
 
 #include "recognition.grpc.pb.h"
 #include "recognition.pb.h"
 #include <grpcpp/impl/codegen/client_context.h>
 #include <grpcpp/security/credentials.h>
+#include <grpcpp/support/channel_arguments.h>
+
+#include <atomic>
+#include <memory>
 
 using namespace speechcenter::recognizer::v1;
 
@@ -15,6 +24,14 @@ typedef RecognitionStreamingResponse Response;
 
 class Audio;
 
+// Per-session changes to the configured recognition, e.g. to try several languages on the same audio.
+struct SessionOptions {
+    std::string language;// configured one when empty
+    std::string topic;// configured topic or grammar when empty
+    bool printResults{true};
+    bool chargeAudioQuota{true};// false when the caller takes the audio of the session from the shared quota
+};
+
 class RecognitionClient {
 public:
     RecognitionClient(const Configuration &configuration);
@@ -23,17 +40,46 @@ public:
 
     void performStreamingRecognition();
 
+    // Prints every final transcript and also hands every result, interim or final, to the listener.
+    void performStreamingRecognition(const Audio &audio, const ResultListener &listener = {});
+
+    // Prepares a session that can be run on any thread and cancelled from another one.
+    std::unique_ptr<RecognitionSession> createSession(const Audio &audio, const ResultListener &listener = {});
+
+    // Builds the audio requests once, so that several sessions can stream them without copying the audio again.
+    // The requests reference the samples of a shared audio and keep it alive; a plain one is copied once.
+    static std::shared_ptr<const AudioRequests> prepareAudio(std::shared_ptr<const Audio> audio);
+
+    static std::shared_ptr<const AudioRequests> prepareAudio(const Audio &audio);
+
+    std::unique_ptr<RecognitionSession> createSession(std::shared_ptr<const AudioRequests> audio,
+                                                      const ResultListener &listener = {},
+                                                      const SessionOptions &options = {});
+
+    // Prepares a session that streams the audio as it is pushed, with no deadline, until it is closed.
+    std::unique_ptr<RecognitionSession> createLiveSession(std::shared_ptr<LiveAudio> audio,
+                                                          const ResultListener &listener = {});
+
+    static void printResult(const RecognitionResult &result);
+
 private:
-    std::unique_ptr<Recognizer::Stub> stub_;
-    std::shared_ptr<grpc::Channel> channel;
-    grpc::ClientContext context;
+    friend class RecognitionSession;
+
+    friend class SpeculativeRecognition;
+
     Configuration configuration;
+    std::string jwt;
+    std::unique_ptr<EndpointPool> endpointPool;
+    std::unique_ptr<SharedQuota> quota;// host-wide, when configured
+    const TransportProfile *transport{nullptr};
+    TraceSession setupTrace;
+    std::atomic<int> sessionCount{0};
 
     static RecognitionResource_Topic convertTopic(const std::string &topicName);
 
     RecognitionStreamingRequest buildRecognitionConfig();
 
-    std::vector<RecognitionStreamingRequest> buildAudioRequests();
+    static std::vector<wire::Frame> buildAudioRequests(const std::shared_ptr<const Audio> &audio);
 
     std::unique_ptr<RecognitionResource> buildRecognitionResource();
 
@@ -45,21 +91,16 @@ private:
 
     RecognitionConfig_AsrVersion buildAsrVersion();
 
-    std::shared_ptr<grpc::Channel> createChannel();
-
-    void
-    write(std::shared_ptr<grpc::ClientReaderWriter<RecognitionStreamingRequest, RecognitionStreamingResponse>> stream);
+    std::shared_ptr<grpc::Channel> createChannel(const std::string &host, bool probe) const;
 
     std::string getJwtToken() const;
 
-    void establishConnection(const std::string &jwt);
-
-    std::shared_ptr<grpc::Channel> getReadyChannel() const;
+    std::shared_ptr<grpc::Channel> establishConnection(const std::string &host,
+                                                       const grpc::ChannelArguments &arguments) const;
 
-    void readFromStream(std::shared_ptr<grpc::ClientReaderWriter<Request, Response>> &stream) const;
+    static std::shared_ptr<grpc::Channel> getReadyChannel(const std::shared_ptr<grpc::Channel> &channel);
 
-    std::shared_ptr<grpc::ClientReaderWriter<Request, Response>> &
-    bidirectionalStream(std::shared_ptr<grpc::ClientReaderWriter<Request, Response>> &stream);
+    void prepareContext(grpc::ClientContext &context) const;
 };
 
 #endif
\ No newline at end of file
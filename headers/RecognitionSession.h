@@ -0,0 +1,162 @@
+#ifndef CLI_CLIENT_RECOGNITIONSESSION_H
+#define CLI_CLIENT_RECOGNITIONSESSION_H
+
+#include "EndpointPool.h"
+#include "LiveAudio.h"
+#include "SessionCapture.h"
+#include "SharedQuota.h"
+#include "Tracing.h"
+#include "WireFormat.h"
+
+#include "recognition.grpc.pb.h"
+#include <grpcpp/impl/codegen/client_context.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+typedef std::function<void(const speechcenter::recognizer::v1::RecognitionResult &result)> ResultListener;
+
+class RecognitionClient;
+
+// Audio requests built once from a decoded audio, in wire format, and shared by every session that streams it.
+struct AudioRequests {
+    std::vector<wire::Frame> chunks;
+    std::chrono::microseconds duration;
+    // Decoding and chunking, merged into the trace of the first session that streams the requests.
+    mutable TraceSession trace;
+};
+
+/*
+ * One recognition of one audio. A session owns the gRPC contexts of its attempts, so a RecognitionClient can run
+ * any number of sessions one after another or at the same time. Every attempt gets a deadline derived from the
+ * audio duration, and cancel() may be called from any thread to abort the session.
+ * A live session streams a LiveAudio after its config instead, for as long as its producer keeps it open.
+ */
+class RecognitionSession {
+public:
+    typedef speechcenter::recognizer::v1::RecognitionStreamingRequest Request;
+    typedef speechcenter::recognizer::v1::RecognitionStreamingResponse Response;
+    typedef wire::Stream Stream;
+
+    // Streams config followed by the shared audio. With printResults false, final transcripts are only handed to the
+    // listener. With chargeAudioQuota false, the audio is not taken from the shared quota before streaming.
+    RecognitionSession(RecognitionClient &client, int index, Request config, std::shared_ptr<const AudioRequests> audio,
+                       std::chrono::microseconds timeout, ResultListener listener, bool printResults = true,
+                       bool chargeAudioQuota = true);
+
+    RecognitionSession(RecognitionClient &client, int index, Request config, std::shared_ptr<LiveAudio> live,
+                       ResultListener listener);
+
+    ~RecognitionSession();
+
+    RecognitionSession(const RecognitionSession &) = delete;
+
+    RecognitionSession &operator=(const RecognitionSession &) = delete;
+
+    // Streams the audio and blocks until the last result. Returns quietly when the session was cancelled.
+    void run();
+
+    // Cancels the active streams, wakes the writer up and lets run() release its share of the audio right away.
+    // A live audio is closed.
+    void cancel();
+
+    bool isCancelled() const;
+
+    // Status of the last stream closed by run(), OK until one is closed.
+    grpc::StatusCode getStatusCode() const;
+
+    // Largest delay between the end of the audio a final result covers and the arrival of that result.
+    std::chrono::microseconds getFinalLatency() const;
+
+    // Duration of the audio written by run(), e.g. before the session was cancelled.
+    std::chrono::microseconds getAudioSent() const;
+
+private:
+    // Keeps its context registered for cancel() while alive.
+    struct Attempt {
+        Attempt(RecognitionSession &session, std::shared_ptr<Endpoint> endpoint, SharedQuota::Lease slot);
+
+        Attempt(Attempt &&) = default;
+
+        ~Attempt();
+
+        SharedQuota::Lease slot;// released after Finish() at the latest
+        RecognitionSession *session;
+        std::shared_ptr<Endpoint> endpoint;
+        std::unique_ptr<grpc::ClientContext> context;
+        std::shared_ptr<Stream> stream;
+    };
+
+    static constexpr std::size_t headLength = 2;// config + first audio chunk
+
+    void recognize();
+
+    // Takes a stream slot of the shared quota, if any. Returns false when it should not wait and none is free.
+    bool takeStreamSlot(SharedQuota::Lease &slot, bool wait);
+
+    bool waitForQuota(std::chrono::milliseconds duration);
+
+    Attempt openAttempt(const std::shared_ptr<Endpoint> &endpoint, SharedQuota::Lease slot);
+
+    std::size_t countRequests() const;
+
+    const wire::Frame &getRequest(std::size_t index) const;
+
+    void record(const wire::Frame &request);
+
+    bool sendHead(const Attempt &attempt) const;
+
+    void startCapture();
+
+    void streamOn(const std::shared_ptr<Endpoint> &endpoint);
+
+    void hedgedStream(const std::vector<std::shared_ptr<Endpoint>> &candidates);
+
+    void finish(Attempt &attempt, int responses);
+
+    int bidirectionalStream(std::shared_ptr<Stream> &stream, std::chrono::steady_clock::time_point start);
+
+    // Writes the same requests to every stream, for as long as any of them takes them.
+    void write(std::vector<std::shared_ptr<Stream>> streams, std::chrono::steady_clock::time_point start);
+
+    static bool writeAll(std::vector<std::shared_ptr<Stream>> &streams, const grpc::ByteBuffer &request);
+
+    bool writeLive(std::vector<std::shared_ptr<Stream>> &streams);
+
+    void trackLatency(const speechcenter::recognizer::v1::RecognitionResult &result,
+                      std::chrono::steady_clock::time_point start);
+
+    // Handles firstResponse, already read from the stream, before reading the next ones.
+    int readFromStream(std::shared_ptr<Stream> &stream, std::chrono::steady_clock::time_point start,
+                       grpc::ByteBuffer *firstResponse = nullptr);
+
+    std::string sessionPath(const std::string &path) const;
+
+    void writeTrace() const;
+
+    RecognitionClient &client;
+    const int index;
+    const wire::Frame config;
+    std::shared_ptr<const AudioRequests> audio;
+    const std::chrono::microseconds timeout;// no deadline when zero
+    const std::shared_ptr<LiveAudio> live;
+    const ResultListener listener;
+    const bool printResults{true};
+    const bool chargeAudioQuota{true};
+    std::unique_ptr<SessionRecorder> recorder;
+    grpc::StatusCode statusCode{grpc::StatusCode::OK};
+    std::chrono::microseconds finalLatency{0};
+    std::chrono::microseconds audioSent{0};
+    TraceSession trace;
+
+    mutable std::mutex mutex;
+    std::condition_variable cancelled;
+    bool cancelRequested{false};
+    std::vector<grpc::ClientContext *> activeContexts;
+};
+
+#endif //CLI_CLIENT_RECOGNITIONSESSION_H
@@ -0,0 +1,33 @@
+#ifndef CLI_CLIENT_RESPONSEARENA_H
+#define CLI_CLIENT_RESPONSEARENA_H
+
+#include "recognition_streaming_response.pb.h"
+
+#include <google/protobuf/arena.h>
+
+#include <memory>
+
+/*
+ * Hands out response messages allocated on an arena that is reset before every read. Strings and repeated
+ * WordInfos of a result are bump-allocated from a block owned by the reader, so a steady stream of results does
+ * not touch the global allocator as long as a response fits in the initial block.
+ */
+class ResponseArena {
+public:
+    explicit ResponseArena(std::size_t initialBlockSize = 64 * 1024);
+
+    ResponseArena(const ResponseArena &) = delete;
+
+    ResponseArena &operator=(const ResponseArena &) = delete;
+
+    // Frees the previous response and returns an empty one.
+    speechcenter::recognizer::v1::RecognitionStreamingResponse *next();
+
+private:
+    static google::protobuf::ArenaOptions buildOptions(char *block, std::size_t size);
+
+    std::unique_ptr<char[]> initialBlock;
+    google::protobuf::Arena arena;
+};
+
+#endif //CLI_CLIENT_RESPONSEARENA_H
@@ -0,0 +1,91 @@
+#ifndef CLI_CLIENT_RTPINGEST_H
+#define CLI_CLIENT_RTPINGEST_H
+
+#include "JitterBuffer.h"
+#include "LiveAudio.h"
+#include "RtpPacket.h"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Receives G.711 RTP flows (PCMU/PCMA at 8 kHz) on a set of UDP ports with a single epoll loop. Every flow, told
+ * apart by source address, port and SSRC, gets its own jitter buffer and LiveAudio, which is handed to the flow
+ * handler on the first packet and closed once the flow has been silent for the idle timeout.
+ */
+class RtpIngest {
+public:
+    typedef std::function<void(const std::string &flow, std::shared_ptr<LiveAudio> audio)> FlowHandler;
+
+    // Binds every port right away; port 0 binds an ephemeral one, see getPorts().
+    RtpIngest(const std::vector<uint16_t> &ports, std::chrono::milliseconds jitterDelay,
+              std::chrono::milliseconds idleTimeout, FlowHandler onFlow);
+
+    ~RtpIngest();
+
+    RtpIngest(const RtpIngest &) = delete;
+
+    RtpIngest &operator=(const RtpIngest &) = delete;
+
+    std::vector<uint16_t> getPorts() const;
+
+    // Serves the flows until stop() is called, then closes the audio of every open flow.
+    void run();
+
+    // Safe to call from any thread and from a signal handler.
+    void stop();
+
+private:
+    typedef JitterBuffer::Clock Clock;
+
+    struct FlowKey {
+        uint32_t address;
+        uint16_t port;
+        uint16_t localPort;
+        uint32_t ssrc;
+
+        bool operator==(const FlowKey &other) const;
+    };
+
+    struct FlowKeyHash {
+        std::size_t operator()(const FlowKey &key) const;
+    };
+
+    struct Flow {
+        std::string name;
+        JitterBuffer jitter;
+        std::shared_ptr<LiveAudio> audio;
+        Clock::time_point lastArrival;
+    };
+
+    typedef std::unordered_map<FlowKey, Flow, FlowKeyHash> Flows;
+
+    static constexpr std::size_t batchSize = 64;
+    static constexpr std::size_t maxDatagramSize = 1500;
+    static constexpr std::chrono::milliseconds chunkDuration{100};
+
+    void receive(int socket, uint16_t localPort);
+
+    void handle(const FlowKey &key, const RtpPacket &packet, Clock::time_point now);
+
+    // Releases the audio that is due and ends idle flows. Returns when it should be called again.
+    Clock::time_point service(Clock::time_point now);
+
+    Flows::iterator endFlow(Flows::iterator flow);
+
+    const std::chrono::milliseconds jitterDelay;
+    const std::chrono::milliseconds idleTimeout;
+    const FlowHandler onFlow;
+    int epollFd{-1};
+    int stopFd{-1};
+    std::vector<int> sockets;
+    std::vector<uint16_t> ports;
+    Flows flows;
+    std::vector<int16_t> samples;
+};
+
+#endif //CLI_CLIENT_RTPINGEST_H
@@ -0,0 +1,30 @@
+#ifndef CLI_CLIENT_RTPPACKET_H
+#define CLI_CLIENT_RTPPACKET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * RTP header fields (RFC 3550) and a view on the payload of a received datagram.
+ */
+struct RtpPacket {
+    static constexpr uint8_t payloadTypePcmu = 0;
+    static constexpr uint8_t payloadTypePcma = 8;
+
+    uint8_t payloadType{0};
+    bool marker{false};
+    uint16_t sequence{0};
+    uint32_t timestamp{0};
+    uint32_t ssrc{0};
+    const uint8_t *payload{nullptr};
+    std::size_t payloadSize{0};
+
+    // Fills packet from a datagram, skipping CSRCs, header extension and padding. Returns false if it is not RTP v2.
+    static bool parse(const uint8_t *data, std::size_t size, RtpPacket &packet);
+
+    // Builds a datagram with a fixed 12 byte header followed by the payload.
+    std::vector<uint8_t> serialize() const;
+};
+
+#endif //CLI_CLIENT_RTPPACKET_H
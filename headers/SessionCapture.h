@@ -0,0 +1,51 @@
+#ifndef CLI_CLIENT_SESSIONCAPTURE_H
+#define CLI_CLIENT_SESSIONCAPTURE_H
+
+#include "recognition_capture.pb.h"
+
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * Appends every message of a session to a capture file as length-delimited CaptureRecords. Requests and
+ * responses are recorded from different threads, so writes are serialised.
+ */
+class SessionRecorder {
+public:
+    explicit SessionRecorder(const std::string &capturePath);
+
+    ~SessionRecorder();
+
+    void record(const speechcenter::recognizer::v1::RecognitionStreamingRequest &request);
+
+    void record(const speechcenter::recognizer::v1::RecognitionStreamingResponse &response);
+
+private:
+    void append(speechcenter::recognizer::v1::CaptureRecord &record);
+
+    std::mutex mutex;
+    std::ofstream output;
+    const std::string capturePath;
+    const std::chrono::steady_clock::time_point start;
+};
+
+class SessionCapture {
+public:
+    explicit SessionCapture(const std::string &capturePath);
+
+    const std::vector<speechcenter::recognizer::v1::CaptureRecord> &getRecords() const { return records; }
+
+    std::chrono::microseconds getDuration() const;
+
+    std::size_t countRequests() const;
+
+    std::size_t countResponses() const;
+
+private:
+    std::vector<speechcenter::recognizer::v1::CaptureRecord> records;
+};
+
+#endif //CLI_CLIENT_SESSIONCAPTURE_H
@@ -0,0 +1,90 @@
+#ifndef CLI_CLIENT_SHAREDQUOTA_H
+#define CLI_CLIENT_SHAREDQUOTA_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+/*
+ * Account quota shared by every client process of a host through a POSIX shared memory object. It limits the
+ * streams open at the same time, each held in a slot tagged with its owner process, and the audio seconds sent per
+ * second, as a token bucket kept in a single timestamp. Both are updated with compare-and-swap only, so a process
+ * that dies never leaves a lock behind, and the slots of dead processes are reclaimed by whoever waits for one.
+ */
+class SharedQuota {
+public:
+    static constexpr std::size_t maxStreams = 256;
+    // Audio that may be sent ahead of the rate, in seconds of schedule.
+    static constexpr std::chrono::seconds burst{10};
+
+    struct Limits {
+        std::size_t streams{0};// unlimited when zero
+        double audioRate{0};// audio seconds per second, unlimited when zero
+    };
+
+    // Sleeps at most the given time while waiting for the quota, returning false to give up.
+    typedef std::function<bool(std::chrono::milliseconds)> Waiter;
+
+    // A stream slot, released when destroyed.
+    class Lease {
+    public:
+        Lease() = default;
+
+        Lease(Lease &&other) noexcept;
+
+        Lease &operator=(Lease &&other) noexcept;
+
+        ~Lease();
+
+        explicit operator bool() const;
+
+        void release();
+
+    private:
+        friend class SharedQuota;
+
+        Lease(SharedQuota *quota, std::size_t slot);
+
+        SharedQuota *quota{nullptr};
+        std::size_t slot{0};
+    };
+
+    // Opens the named object, creating it with these limits if it does not exist yet. Processes that join later use
+    // the limits of the creator.
+    SharedQuota(const std::string &name, const Limits &limits);
+
+    ~SharedQuota();
+
+    SharedQuota(const SharedQuota &) = delete;
+
+    SharedQuota &operator=(const SharedQuota &) = delete;
+
+    // Takes a stream slot, or returns an empty lease when the waiter gives up. Without a stream limit the lease is
+    // never empty and holds nothing.
+    Lease acquireStream(const Waiter &wait);
+
+    // Takes the tokens of this much audio once the bucket is within the burst. Returns false if the waiter gave up.
+    bool acquireAudio(std::chrono::microseconds audio, const Waiter &wait);
+
+    // Takes the tokens of audio already being sent, e.g. live audio that cannot wait, without blocking.
+    void consumeAudio(std::chrono::microseconds audio);
+
+    // Frees the slots of processes that exited without releasing them and returns how many.
+    std::size_t reclaimStale();
+
+    const Limits &getLimits() const;
+
+private:
+    struct Segment;
+
+    std::int64_t reserve(std::chrono::microseconds audio, bool wait);
+
+    const std::string name;
+    Limits limits;
+    std::uint64_t owner{0};
+    Segment *segment{nullptr};
+};
+
+#endif //CLI_CLIENT_SHAREDQUOTA_H
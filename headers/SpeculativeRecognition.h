@@ -0,0 +1,77 @@
+#ifndef CLI_CLIENT_SPECULATIVERECOGNITION_H
+#define CLI_CLIENT_SPECULATIVERECOGNITION_H
+
+#include "RecognitionClient.h"
+
+#include <condition_variable>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * Recognizes one audio with several candidate languages or topics at once when the right one is unknown. Every
+ * candidate streams the same audio requests. After the warm-up, the candidate whose results are the most confident
+ * so far is kept and the others are cancelled, so the cost is one full recognition plus a short probe per extra
+ * candidate. Results are held back until the choice is made and only those of the kept candidate are printed and
+ * handed to the listener.
+ */
+class SpeculativeRecognition {
+public:
+    struct Candidate {
+        std::string language;
+        std::string topic;
+    };
+
+    SpeculativeRecognition(RecognitionClient &client, std::vector<Candidate> candidates,
+                           std::chrono::milliseconds warmUp);
+
+    ~SpeculativeRecognition();
+
+    // Blocks until the kept candidate has finished, rethrowing its error if it failed.
+    void run(const Audio &audio, const ResultListener &listener = {});
+
+    void run(std::shared_ptr<const AudioRequests> audio, const ResultListener &listener = {});
+
+    // The kept candidate and its session, once run() has chosen it.
+    const Candidate &getWinner() const;
+
+    const RecognitionSession *getSession() const;
+
+private:
+    struct Contender {
+        Candidate candidate;
+        std::unique_ptr<RecognitionSession> session;
+        std::future<void> running;
+        std::vector<RecognitionResult> held;
+        double confidenceSum{0};
+        double confidenceWeight{0};
+        double interimConfidence{-1};
+        bool finished{false};
+        std::exception_ptr error;
+
+        // Word-weighted mean confidence of the final results, or that of the last interim result without any.
+        double score() const;
+    };
+
+    void onResult(std::size_t index, const RecognitionResult &result);
+
+    bool allFinished() const;
+
+    bool anyScored() const;
+
+    std::size_t choose() const;
+
+    static std::string describe(const Candidate &candidate);
+
+    RecognitionClient &client;
+    const std::chrono::milliseconds warmUp;
+    std::vector<Contender> contenders;
+    ResultListener listener;
+    int winner{-1};
+    std::mutex mutex;
+    std::condition_variable changed;
+};
+
+#endif //CLI_CLIENT_SPECULATIVERECOGNITION_H
@@ -0,0 +1,49 @@
+#ifndef CLI_CLIENT_STANDINSERVER_H
+#define CLI_CLIENT_STANDINSERVER_H
+
+#include "SessionCapture.h"
+
+#include "recognition.grpc.pb.h"
+
+#include <grpcpp/server.h>
+
+#include <memory>
+#include <string>
+
+/*
+ * Local stand-in for the Speech Center recognizer. Every stream it accepts is answered with the responses of a
+ * captured session. A response is released once the requests that preceded it in the capture have arrived and
+ * its recorded offset, multiplied by the time scale, has elapsed since the stream started. A time scale of 0
+ * answers as fast as the client writes.
+ */
+class StandInServer : public speechcenter::recognizer::v1::Recognizer::Service {
+public:
+    StandInServer(const SessionCapture &capture, double timeScale);
+
+    ~StandInServer() override;
+
+    // Starts listening on an insecure port and returns the port actually bound (useful with "localhost:0").
+    int start(const std::string &address);
+
+    void wait();
+
+    void shutdown();
+
+    grpc::Status StreamingRecognize(grpc::ServerContext *context,
+                                    grpc::ServerReaderWriter<speechcenter::recognizer::v1::RecognitionStreamingResponse,
+                                            speechcenter::recognizer::v1::RecognitionStreamingRequest> *stream) override;
+
+private:
+    struct ScheduledResponse {
+        std::chrono::microseconds offset;
+        std::size_t requestsBefore;
+        const speechcenter::recognizer::v1::RecognitionStreamingResponse *response;
+    };
+
+    const SessionCapture &capture;
+    const double timeScale;
+    std::vector<ScheduledResponse> schedule;
+    std::unique_ptr<grpc::Server> server;
+};
+
+#endif //CLI_CLIENT_STANDINSERVER_H
@@ -0,0 +1,99 @@
+#ifndef CLI_CLIENT_TRACING_H
+#define CLI_CLIENT_TRACING_H
+
+#include <string>
+
+/*
+ * Scoped trace spans written as Chrome/Perfetto trace-event JSON. Spans are recorded into the TraceSession bound
+ * to the current thread and are dropped when no session is bound. Unless the build defines SPEECH_CENTER_TRACING
+ * (cmake -DENABLE_TRACING=ON) TRACE_SCOPE expands to nothing and TraceSession is an empty type.
+ */
+#ifdef SPEECH_CENTER_TRACING
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+constexpr bool tracingEnabled = true;
+
+struct TraceEvent {
+    const char *name;
+    int64_t startUs;
+    int64_t durationUs;
+    uint32_t threadId;
+};
+
+class TraceSession {
+public:
+    // Binds a session to the calling thread for the lifetime of the scope.
+    class Scope {
+    public:
+        explicit Scope(TraceSession *session);
+
+        ~Scope();
+
+    private:
+        TraceSession *previous;
+    };
+
+    void add(const TraceEvent &event);
+
+    // Moves the events recorded by another session into this one.
+    void merge(TraceSession &other);
+
+    void write(const std::string &path) const;
+
+    static TraceSession *current();
+
+    static int64_t now();
+
+    static uint32_t threadId();
+
+private:
+    mutable std::mutex mutex;
+    std::vector<TraceEvent> events;
+};
+
+class TraceSpan {
+public:
+    explicit TraceSpan(const char *name) : session(TraceSession::current()), name(name),
+                                           start(session ? TraceSession::now() : 0) {}
+
+    ~TraceSpan() {
+        if (session)
+            session->add({name, start, TraceSession::now() - start, TraceSession::threadId()});
+    }
+
+private:
+    TraceSession *session;
+    const char *name;
+    int64_t start;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name)
+
+#else
+
+constexpr bool tracingEnabled = false;
+
+class TraceSession {
+public:
+    class Scope {
+    public:
+        explicit Scope(TraceSession *) {}
+    };
+
+    void merge(TraceSession &) {}
+
+    void write(const std::string &) const {}
+
+    static TraceSession *current() { return nullptr; }
+};
+
+#define TRACE_SCOPE(name)
+
+#endif
+
+#endif //CLI_CLIENT_TRACING_H
@@ -0,0 +1,80 @@
+#ifndef CLI_CLIENT_TRANSCRIPTCACHE_H
+#define CLI_CLIENT_TRANSCRIPTCACHE_H
+
+#include "recognition_streaming_response.pb.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Audio;
+
+class Configuration;
+
+/*
+ * On-disk cache of final results keyed by a fingerprint of the PCM payload and of the configuration fields that
+ * change the output. Values are appended to a data file and located through a memory-mapped, open-addressed hash
+ * table of fixed-size entries, so a lookup reads a few slots whatever the size of the cache; storing a key again
+ * points its slot to the new value. Stores take an exclusive lock on the data file so several processes can share
+ * one cache directory. The table is rebuilt at twice its size in a new file when half full, and the other
+ * processes follow it on their next lookup.
+ */
+class TranscriptCache {
+public:
+    explicit TranscriptCache(const std::string &directory);
+
+    ~TranscriptCache();
+
+    TranscriptCache(const TranscriptCache &) = delete;
+
+    TranscriptCache &operator=(const TranscriptCache &) = delete;
+
+    static uint64_t buildKey(const Audio &audio, const Configuration &configuration);
+
+    bool lookup(uint64_t key, std::vector<speechcenter::recognizer::v1::RecognitionResult> &results);
+
+    // Nothing is stored for no results, so that an empty answer is never replayed in place of a transcript.
+    void store(uint64_t key, const std::vector<speechcenter::recognizer::v1::RecognitionResult> &results);
+
+    static uint64_t hash(const void *data, std::size_t size, uint64_t seed);
+
+private:
+    struct IndexHeader {
+        uint64_t magic;
+        uint64_t capacity;// slots, a power of two
+        uint64_t count;
+        uint64_t reserved;
+    };
+
+    struct IndexEntry {
+        uint64_t key;// zero for an empty slot
+        uint64_t offset;
+        uint32_t length;
+        uint32_t checksum;
+    };
+
+    // Opens the index, or creates an empty one when there is none or it is invalid.
+    void openIndex();
+
+    // Follows an index that another process replaced with a larger one.
+    void refreshIndex();
+
+    bool mapIndex();
+
+    void unmapIndex();
+
+    void rebuildIndex(uint64_t capacity, const std::vector<IndexEntry> &entries);
+
+    // The slot holding the key, or the empty slot where it goes; null only when the table is full.
+    IndexEntry *findSlot(uint64_t key) const;
+
+    const std::string directory;
+    const std::string indexPath;
+    int dataFile{-1};
+    int indexFile{-1};
+    IndexHeader *header{nullptr};
+    IndexEntry *slots{nullptr};
+    std::size_t mappedBytes{0};
+};
+
+#endif //CLI_CLIENT_TRANSCRIPTCACHE_H
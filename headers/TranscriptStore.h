@@ -0,0 +1,121 @@
+#ifndef CLI_CLIENT_TRANSCRIPTSTORE_H
+#define CLI_CLIENT_TRANSCRIPTSTORE_H
+
+#include "recognition_streaming_response.pb.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Binary transcript of one audio, stored by column so that queries only decode what they need. Words are ids into
+ * a sorted dictionary; start times are deltas from the previous word and end times offsets from their own start, in
+ * milliseconds and as varints; confidences are one byte each and speakers are runs of words. A skip index gives the
+ * start time and column positions of every block of words, so a time range is found by binary search and a term by
+ * scanning the id column alone. The header, the skip index and the term offsets are written and mapped as they are in
+ * memory, so multi-byte fields are little-endian and only little-endian hosts are supported.
+ */
+namespace transcript {
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t words;
+        uint32_t terms;
+        uint32_t speakerRuns;
+        uint32_t blocks;
+        uint32_t longestWordMs;
+        uint32_t reserved;
+        // Offsets of the columns from the start of the file.
+        uint64_t termOffsets;// terms + 1 uint32 offsets into termBytes
+        uint64_t termBytes;
+        uint64_t ids;
+        uint64_t starts;
+        uint64_t ends;
+        uint64_t confidences;
+        uint64_t speakers;
+        uint64_t blockIndex;
+        uint64_t fileSize;
+    };
+
+    // Where the words of a block begin, for decoding from there.
+    struct Block {
+        uint32_t firstWord;
+        uint32_t startMs;
+        uint32_t ids;
+        uint32_t starts;
+        uint32_t ends;
+    };
+
+    constexpr uint32_t blockWords = 128;
+
+    struct Word {
+        std::string_view text;
+        double startTime;
+        double endTime;
+        float confidence;
+        uint32_t speaker;
+        uint32_t index;
+    };
+
+}
+
+// Collects the words of the final results as they are read and writes them as one transcript file.
+class TranscriptWriter {
+public:
+    // Interim results are ignored.
+    void add(const speechcenter::recognizer::v1::RecognitionResult &result);
+
+    std::size_t countWords() const;
+
+    // Replaces the file atomically, so a reader never sees half of it.
+    void write(const std::string &path) const;
+
+private:
+    std::unordered_map<std::string, uint32_t> termIds;
+    std::vector<const std::string *> terms;// in order of first appearance
+    std::vector<uint32_t> ids;
+    std::vector<uint32_t> startsMs;
+    std::vector<uint32_t> endsMs;
+    std::vector<uint8_t> confidences;
+    std::vector<uint32_t> speakers;
+};
+
+// Memory maps a transcript file and answers queries on it.
+class TranscriptReader {
+public:
+    explicit TranscriptReader(const std::string &path);
+
+    ~TranscriptReader();
+
+    TranscriptReader(const TranscriptReader &) = delete;
+
+    TranscriptReader &operator=(const TranscriptReader &) = delete;
+
+    std::size_t countWords() const;
+
+    // Words spoken, even partly, between the two times in seconds.
+    std::vector<transcript::Word> between(double from, double to) const;
+
+    // Every occurrence of the word, which must match exactly.
+    std::vector<transcript::Word> find(const std::string &term) const;
+
+private:
+    class Cursor;
+
+    std::string_view term(uint32_t id) const;
+
+    uint32_t speakerOf(uint32_t index) const;
+
+    const std::string path;
+    const char *data{nullptr};
+    std::size_t size{0};
+    transcript::Header header{};
+    const transcript::Block *blocks{nullptr};
+    std::vector<uint32_t> speakerRunEnds;// index of the first word after each run
+    std::vector<uint32_t> speakerRunIds;
+};
+
+#endif //CLI_CLIENT_TRANSCRIPTSTORE_H
@@ -0,0 +1,59 @@
+#ifndef CLI_CLIENT_TRANSCRIPTTIMELINE_H
+#define CLI_CLIENT_TRANSCRIPTTIMELINE_H
+
+#include "recognition_streaming_response.pb.h"
+
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+/*
+ * Live transcript of one stream, assembled from its interim and final results. The words of final results are
+ * frozen; every interim result revises only the tail after them, the segment being spoken. Applying a result
+ * compares it with the tail alone, skipping the words both share at either end, and tells subscribers which range
+ * of words changed, so the work done here and downstream follows the size of the change and not the transcript.
+ * Words are matched on their text; a matched word only takes the timing, confidence and speaker of the revision.
+ */
+class TranscriptTimeline {
+public:
+    struct Word {
+        std::string text;
+        float startTime;
+        float endTime;
+        float confidence;
+        uint32_t speaker;
+    };
+
+    // The words from first, removed of them before, are now the inserted ones. A final diff freezes the tail.
+    // Nothing removed or inserted, and not final, means only the scores of words in the tail were revised.
+    struct Diff {
+        std::size_t first;
+        std::size_t removed;
+        std::span<const Word> inserted;// valid during the call only
+        bool final;
+    };
+
+    typedef std::function<void(const Diff &diff)> Subscriber;
+
+    void subscribe(Subscriber subscriber);
+
+    // Notifies the subscribers when the words or their scores change, and always for a final result.
+    void apply(const speechcenter::recognizer::v1::RecognitionResult &result);
+
+    const std::vector<Word> &getWords() const;
+
+    std::size_t countFrozen() const;
+
+    // The words from first on, separated by spaces.
+    std::string text(std::size_t first = 0) const;
+
+private:
+    std::vector<Word> words;
+    std::size_t frozen{0};
+    std::vector<Word> revision;// reused for every result
+    std::vector<Subscriber> subscribers;
+};
+
+#endif //CLI_CLIENT_TRANSCRIPTTIMELINE_H
@@ -0,0 +1,37 @@
+#ifndef CLI_CLIENT_TRANSPORTPROFILE_H
+#define CLI_CLIENT_TRANSPORTPROFILE_H
+
+#include <grpc/compression.h>
+#include <grpcpp/client_context.h>
+#include <grpcpp/support/channel_arguments.h>
+#include <grpcpp/support/config.h>
+
+#include <string>
+#include <vector>
+
+/*
+ * Named presets of the gRPC channel and call options that matter when streaming PCM: HTTP/2 flow-control windows,
+ * write buffering, message size limits and compression of the requests. The default profile leaves everything as
+ * gRPC sets it. A zero or negative field also keeps the gRPC default.
+ */
+struct TransportProfile {
+    std::string name;
+    grpc_compression_algorithm compression;// of the requests of every call
+    // Bytes the server may send on a stream ahead of the reader; BDP probing grows it from there. The window for
+    // the audio sent is the one the server advertises.
+    int streamWindow;
+    bool bdpProbe;
+    int writeBufferSize;// bytes gRPC may buffer before a write blocks
+    int maxMessageSize;// of the responses
+    bool coalesceHead;// sends the head of a stream, config and first chunk, in one flush
+
+    static const TransportProfile &byName(const std::string &name);
+
+    static std::vector<std::string> names();
+
+    void apply(grpc::ChannelArguments &arguments) const;
+
+    void apply(grpc::ClientContext &context) const;
+};
+
+#endif //CLI_CLIENT_TRANSPORTPROFILE_H
@@ -0,0 +1,49 @@
+#ifndef CLI_CLIENT_WIREFORMAT_H
+#define CLI_CLIENT_WIREFORMAT_H
+
+#include "recognition.grpc.pb.h"
+
+#include <grpcpp/channel.h>
+#include <grpcpp/client_context.h>
+#include <grpcpp/support/byte_buffer.h>
+#include <grpcpp/support/sync_stream.h>
+
+#include <memory>
+#include <string>
+
+/*
+ * Requests and responses of StreamingRecognize as raw wire buffers. An audio request is only a field tag and a
+ * length in front of the audio bytes, so it is built as a small header slice followed by a slice that references
+ * the samples where they already are. Streaming the buffers skips both the copy into a request message and its
+ * serialization on every write.
+ */
+namespace wire {
+
+    typedef grpc::ClientReaderWriter<grpc::ByteBuffer, grpc::ByteBuffer> Stream;
+
+    // A request in wire format and the audio bytes it carries, zero for a config.
+    struct Frame {
+        grpc::ByteBuffer buffer;
+        std::size_t audioBytes{0};
+    };
+
+    Frame serialize(const speechcenter::recognizer::v1::RecognitionStreamingRequest &request);
+
+    // References the bytes without copying them. The owner keeps them alive for as long as any copy of the frame.
+    Frame audioFrame(const void *data, std::size_t length, std::shared_ptr<const void> owner);
+
+    // Takes over the string, e.g. a chunk of live audio, also without copying it.
+    Frame audioFrame(std::string audio);
+
+    // Both leave the buffer empty, as gRPC does when it parses a message.
+    bool parse(grpc::ByteBuffer &buffer, speechcenter::recognizer::v1::RecognitionStreamingRequest &request);
+
+    bool parse(grpc::ByteBuffer &buffer, speechcenter::recognizer::v1::RecognitionStreamingResponse &response);
+
+    // Opens StreamingRecognize on the channel as a generic call that sends and receives raw buffers.
+    std::unique_ptr<Stream> openRecognitionStream(const std::shared_ptr<grpc::Channel> &channel,
+                                                  grpc::ClientContext *context);
+
+}
+
+#endif //CLI_CLIENT_WIREFORMAT_H
@@ -55,4 +55,9 @@ public:
     explicit StreamException(const std::string message);
 };
 
+class EndpointUnavailable : public StreamException {
+public:
+    EndpointUnavailable(const std::string &host, const std::string &message);
+};
+
 #endif
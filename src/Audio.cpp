@@ -3,8 +3,30 @@
 #include "gRpcExceptions.h"
 
 #include "logger.h"
+#include "Tracing.h"
 #include "sndfile.hh"
 
+namespace {
+
+    constexpr sf_count_t decodeBlockSamples = 32768;
+
+    bool isSupportedFormat(int format) {
+        const int container = format & SF_FORMAT_TYPEMASK;
+        const int encoding = format & SF_FORMAT_SUBMASK;
+        switch (container) {
+            case SF_FORMAT_WAV:
+                return encoding == SF_FORMAT_PCM_16;
+            case SF_FORMAT_FLAC:
+                return true;
+            case SF_FORMAT_OGG:
+                return encoding == SF_FORMAT_VORBIS || encoding == SF_FORMAT_OPUS;
+            default:
+                return false;
+        }
+    }
+
+}
+
 Audio::Audio(const int16_t *const _data, int _samplingRate, int lengthInFrames) : length(lengthInFrames),
                                                                                   samplingRate(_samplingRate) {
     data = std::make_unique<int16_t[]>(length);
@@ -13,18 +35,47 @@ Audio::Audio(const int16_t *const _data, int _samplingRate, int lengthInFrames)
 
 Audio::~Audio() = default;
 
-Audio::Audio(const std::string &audioPath) {
+Audio::Audio(const std::string &audioPath, bool analyze) {
+    // Decoded ahead of its session, often on the prefetcher thread, where no session trace is bound.
+    TraceSession::Scope traceScope(&trace);
+    TRACE_SCOPE("Audio::decode");
     SndfileHandle sndfileHandle(audioPath);
-    auto length = sndfileHandle.frames();
-    auto data = new int16_t[length];
-    length = sndfileHandle.read(data, length);
-    auto samplingRate = sndfileHandle.samplerate();
-    if (!sndfileHandle.formatCheck(SF_FORMAT_PCM_16 | SF_FORMAT_WAV, sndfileHandle.channels(), samplingRate))
+    if (sndfileHandle.error())
+        throw IOError("Unable to open audio '" + audioPath + "': " + sndfileHandle.strError());
+    if (!isSupportedFormat(sndfileHandle.format()))
         throw GrpcException("Unsupported file audio format");
-    INFO("Read {} samples with {} bytes per sample", length, sizeof(data));
 
-    this->length = length;
-    this->samplingRate = samplingRate;
-    this->data = std::make_unique<int16_t[]>(length);
-    std::copy_n(data, length, this->data.get());
+    // Compressed containers decode block by block straight into the sample buffer. The header length is only a
+    // hint, since it may be missing or approximate for Ogg streams.
+    int64_t capacity = std::max<int64_t>(sndfileHandle.frames() * sndfileHandle.channels(), decodeBlockSamples);
+    data = std::make_unique<int16_t[]>(capacity);
+    // Each block is analyzed as soon as it is decoded, while it is still in cache.
+    std::unique_ptr<AudioAnalyzer> analyzer;
+    if (analyze)
+        analyzer = std::make_unique<AudioAnalyzer>(sndfileHandle.samplerate(), sndfileHandle.channels());
+    sf_count_t read;
+    while ((read = sndfileHandle.read(&data[length], std::min(decodeBlockSamples, capacity - length))) > 0) {
+        if (analyzer)
+            analyzer->add(&data[length], read);
+        length += read;
+        if (length == capacity) {
+            auto grown = std::make_unique<int16_t[]>(capacity * 2);
+            std::copy_n(data.get(), length, grown.get());
+            data = std::move(grown);
+            capacity *= 2;
+        }
+    }
+    samplingRate = sndfileHandle.samplerate();
+    if (analyzer)
+        report = analyzer->finish(sndfileHandle.frames() * sndfileHandle.channels());
+    INFO("Read {} samples with {} bytes per sample", length, getBytesPerSamples());
+}
+
+std::chrono::microseconds Audio::probeDuration(const std::string &audioPath) {
+    SndfileHandle sndfileHandle(audioPath);
+    if (sndfileHandle.error())
+        throw IOError("Unable to open audio '" + audioPath + "': " + sndfileHandle.strError());
+    if (sndfileHandle.samplerate() <= 0 || sndfileHandle.frames() <= 0)
+        return std::chrono::microseconds(0);
+    return std::chrono::microseconds(sndfileHandle.frames() * 1000000 / sndfileHandle.samplerate());
 }
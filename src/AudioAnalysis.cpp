@@ -0,0 +1,181 @@
+#include "AudioAnalysis.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+    constexpr double fullScale = 32768;
+    constexpr uint64_t silentMeanSquare = 10737;// -50 dBFS
+    constexpr double narrowbandLevel = -50;// dB of energy above 5 kHz, relative to the whole
+    constexpr std::size_t filterBlock = 4096;
+
+    // Windowed-sinc high-pass at 5 kHz for 16 kHz audio: with a Blackman window of 63 taps it passes 5.7 kHz and up
+    // and stops 4.3 kHz and below by more than 70 dB.
+    const std::array<float, AudioAnalyzer::taps> highPass = [] {
+        constexpr double cutoff = 5000.0 / 16000;
+        constexpr auto middle = static_cast<double>(AudioAnalyzer::taps - 1) / 2;
+        std::array<double, AudioAnalyzer::taps> lowPass{};
+        double gain = 0;
+        for (std::size_t n = 0; n < AudioAnalyzer::taps; ++n) {
+            double x = n - middle;
+            double sinc = x == 0 ? 2 * cutoff : std::sin(2 * M_PI * cutoff * x) / (M_PI * x);
+            double phase = 2 * M_PI * n / (AudioAnalyzer::taps - 1);
+            lowPass[n] = sinc * (0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2 * phase));
+            gain += lowPass[n];
+        }
+        std::array<float, AudioAnalyzer::taps> coefficients{};
+        for (std::size_t n = 0; n < AudioAnalyzer::taps; ++n)
+            coefficients[n] = static_cast<float>((n == AudioAnalyzer::taps / 2 ? 1 : 0) - lowPass[n] / gain);
+        return coefficients;
+    }();
+
+    double toDbfs(double amplitude) {
+        return amplitude > 0 ? 20 * std::log10(amplitude / fullScale) : -120;
+    }
+
+    std::string toPercent(double fraction) {
+        std::ostringstream percent;
+        percent << std::setprecision(2) << fraction * 100 << '%';
+        return percent.str();
+    }
+
+}
+
+std::vector<std::string> AudioReport::findProblems(uint32_t streamedRate) const {
+    std::vector<std::string> problems;
+    if (frames == 0) {
+        problems.emplace_back("no audio");
+        return problems;
+    }
+    if (declaredFrames > frames)
+        problems.push_back("truncated, " + std::to_string(frames) + " of " + std::to_string(declaredFrames) +
+                           " frames decoded");
+    if (sampleRate != streamedRate)
+        problems.push_back("sampled at " + std::to_string(sampleRate) + " Hz but streamed as " +
+                           std::to_string(streamedRate) + " Hz");
+    if (channels > 1)
+        problems.push_back(std::to_string(channels) + " channels interleaved but streamed as mono");
+    const bool silent = silence >= 0.99;
+    if (silent)
+        problems.emplace_back("silent");
+    if (clipping > 0.001)
+        problems.push_back("clipped, " + toPercent(clipping) + " of the samples at full scale");
+    if (std::abs(dcOffset) > 0.02)
+        problems.push_back("DC offset of " + toPercent(dcOffset) + " of full scale");
+    if (!silent && sampleRate == 16000 && bandwidth <= 4000)
+        problems.emplace_back("no content above 4 kHz, probably 8 kHz audio upsampled to 16 kHz");
+    return problems;
+}
+
+void AudioReport::writeTsvHeader(std::ostream &out) {
+    out << "path\tseconds\tsample_rate\tchannels\trms_dbfs\tpeak_dbfs\tclipping\tdc_offset\tsilence\thigh_band_db"
+           "\tbandwidth_hz\tproblems\n";
+}
+
+void AudioReport::writeTsv(std::ostream &out, const std::string &path,
+                           const std::vector<std::string> &problems) const {
+    out << path << '\t' << (sampleRate > 0 ? static_cast<double>(frames) / sampleRate : 0) << '\t' << sampleRate
+        << '\t' << channels << '\t' << rms << '\t' << peak << '\t' << clipping << '\t' << dcOffset << '\t'
+        << silence << '\t' << highBand << '\t' << bandwidth << '\t';
+    for (std::size_t i = 0; i < problems.size(); ++i)
+        out << (i ? "; " : "") << problems[i];
+    out << '\n';
+}
+
+AudioAnalyzer::AudioAnalyzer(int64_t sampleRate, int channels) :
+        sampleRate(sampleRate), channels(channels), frameLength(std::max<std::size_t>(sampleRate / 100, 1)),
+        window(taps - 1, 0.0f) {}
+
+void AudioAnalyzer::add(const int16_t *samples, std::size_t count) {
+    frames += static_cast<int64_t>(count);
+    if (sampleRate == 16000)
+        filter(samples, count);
+    while (count > 0) {
+        // Pieces that end at most at the end of a 10 ms frame.
+        auto length = std::min(count, frameLength - framePosition);
+        addFrame(samples, length);
+        samples += length;
+        count -= length;
+    }
+}
+
+void AudioAnalyzer::addFrame(const int16_t *samples, std::size_t count) {
+    int64_t blockSum = 0;
+    uint64_t blockSquares = 0;
+    int32_t blockPeak = 0;
+    int64_t blockClipped = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        int32_t sample = samples[i];
+        int32_t magnitude = sample < 0 ? -sample : sample;
+        blockSum += sample;
+        blockSquares += static_cast<uint32_t>(sample * sample);
+        blockPeak = std::max(blockPeak, magnitude);
+        blockClipped += magnitude >= 32767;
+    }
+    sum += blockSum;
+    squares += blockSquares;
+    peak = std::max(peak, blockPeak);
+    clipped += blockClipped;
+    frameSquares += blockSquares;
+    framePosition += count;
+    if (framePosition == frameLength) {
+        ++completeFrames;
+        silentFrames += frameSquares < silentMeanSquare * frameLength;
+        framePosition = 0;
+        frameSquares = 0;
+    }
+}
+
+void AudioAnalyzer::filter(const int16_t *samples, std::size_t count) {
+    constexpr std::size_t history = taps - 1;
+    for (std::size_t offset = 0; offset < count; offset += filterBlock) {
+        const auto length = std::min(filterBlock, count - offset);
+        window.resize(history + length);
+        std::copy_n(samples + offset, length, window.begin() + history);
+        highPassed.assign(length, 0.0f);
+        // Tap by tap over the whole block, so the inner loop is a vectorized multiply-add without dependencies.
+        for (std::size_t k = 0; k < taps; ++k) {
+            const float coefficient = highPass[k];
+            const float *input = window.data() + history - k;
+            float *output = highPassed.data();
+            for (std::size_t i = 0; i < length; ++i)
+                output[i] += coefficient * input[i];
+        }
+        double blockSquares = 0;
+        for (auto value: highPassed)
+            blockSquares += static_cast<double>(value) * value;
+        highSquares += blockSquares;
+        std::copy(window.end() - history, window.end(), window.begin());
+        window.resize(history);
+    }
+}
+
+AudioReport AudioAnalyzer::finish(int64_t declaredFrames) const {
+    AudioReport report;
+    report.frames = frames;
+    report.declaredFrames = declaredFrames;
+    report.sampleRate = sampleRate;
+    report.channels = channels;
+    report.bandwidth = static_cast<uint32_t>(sampleRate / 2);
+    if (frames == 0)
+        return report;
+    report.rms = toDbfs(std::sqrt(static_cast<double>(squares) / frames));
+    report.peak = toDbfs(peak);
+    report.clipping = static_cast<double>(clipped) / frames;
+    report.dcOffset = static_cast<double>(sum) / frames / fullScale;
+    // A last frame shorter than 10 ms only counts when it is all there is.
+    if (completeFrames > 0)
+        report.silence = static_cast<double>(silentFrames) / completeFrames;
+    else
+        report.silence = frameSquares < silentMeanSquare * framePosition ? 1 : 0;
+    if (sampleRate == 16000 && squares > 0) {
+        report.highBand = highSquares > 0 ? 10 * std::log10(highSquares / static_cast<double>(squares)) : -120;
+        if (report.highBand < narrowbandLevel)
+            report.bandwidth = 4000;
+    }
+    return report;
+}
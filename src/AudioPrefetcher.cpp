@@ -0,0 +1,56 @@
+#include "AudioPrefetcher.h"
+
+#include "gRpcExceptions.h"
+
+AudioPrefetcher::AudioPrefetcher(const std::vector<std::string> &paths, std::size_t readAhead, bool analyze) :
+        paths(paths), readAhead(std::max<std::size_t>(readAhead, 1)), analyze(analyze) {
+    decoder = std::thread(&AudioPrefetcher::decodeLoop, this);
+}
+
+AudioPrefetcher::~AudioPrefetcher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    decoder.join();
+}
+
+bool AudioPrefetcher::hasNext() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return consumed < paths.size();
+}
+
+std::shared_ptr<const Audio> AudioPrefetcher::next() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (consumed == paths.size())
+        throw IOError("No more audio files to read");
+    changed.wait(lock, [this] { return !ready.empty(); });
+    auto decoded = std::move(ready.front());
+    ready.pop_front();
+    ++consumed;
+    changed.notify_all();
+    if (decoded.error)
+        std::rethrow_exception(decoded.error);
+    return decoded.audio;
+}
+
+void AudioPrefetcher::decodeLoop() {
+    for (const auto &path: paths) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [this] { return stopping || ready.size() < readAhead; });
+            if (stopping)
+                return;
+        }
+        Decoded decoded;
+        try {
+            decoded.audio = std::make_shared<const Audio>(path, analyze);
+        } catch (...) {
+            decoded.error = std::current_exception();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        ready.emplace_back(std::move(decoded));
+        changed.notify_all();
+    }
+}
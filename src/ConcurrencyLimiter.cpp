@@ -0,0 +1,71 @@
+#include "ConcurrencyLimiter.h"
+
+#include "logger.h"
+
+#include <algorithm>
+
+ConcurrencyLimiter::ConcurrencyLimiter(std::size_t maxLimit, LimitListener listener) :
+        maxLimit(static_cast<double>(std::max<std::size_t>(1, maxLimit))), listener(std::move(listener)) {}
+
+ConcurrencyLimiter::Ticket ConcurrencyLimiter::acquire() {
+    std::unique_lock<std::mutex> lock(mutex);
+    released.wait(lock, [this] { return inFlight < allowed(); });
+    ++inFlight;
+    const Ticket ticket{epoch};
+    publish(lock);
+    return ticket;
+}
+
+void ConcurrencyLimiter::release(const Ticket &ticket, Outcome outcome, std::chrono::microseconds latency) {
+    std::unique_lock<std::mutex> lock(mutex);
+    const auto previous = allowed();
+    // Growing only makes sense while the limit is actually in use, not when the run has fewer files left.
+    const bool saturated = 2 * inFlight >= previous;
+    --inFlight;
+    if (outcome == Outcome::Overload) {
+        if (ticket.epoch == epoch) {
+            limit = std::max(1.0, limit * overloadBackoff);
+            ++epoch;
+        }
+    } else if (outcome == Outcome::Success && latency.count() > 0) {
+        const auto sample = static_cast<double>(latency.count());
+        baselineUs = baselineUs == 0 || sample < baselineUs ? sample
+                                                            : baselineUs + baselineDrift * (sample - baselineUs);
+        if (sample <= baselineUs * latencyTolerance) {
+            if (saturated)
+                limit = std::min(maxLimit, limit + 1 / limit);
+        } else {
+            limit = std::max(1.0, limit * latencyBackoff);
+        }
+    }
+    if (allowed() != previous)
+        INFO("Concurrency limit {} -> {}", previous, allowed());
+    released.notify_all();
+    publish(lock);
+}
+
+double ConcurrencyLimiter::getLimit() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return limit;
+}
+
+std::size_t ConcurrencyLimiter::getInFlight() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return inFlight;
+}
+
+void ConcurrencyLimiter::publish(std::unique_lock<std::mutex> &lock) {
+    if (!listener)
+        return;
+    const auto snapshotLimit = limit;
+    const auto snapshotInFlight = inFlight;
+    // Taken before the state is unlocked, so the listener sees the snapshots in the order they were taken.
+    std::lock_guard<std::mutex> publishing(listenerMutex);
+    lock.unlock();
+    listener(snapshotLimit, snapshotInFlight);
+}
+
+std::size_t ConcurrencyLimiter::allowed() const {
+    // The additive steps of 1 / limit add up to an integer only up to rounding.
+    return static_cast<std::size_t>(limit + 1e-9);
+}
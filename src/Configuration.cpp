@@ -1,12 +1,84 @@
 #include "Configuration.h"
+#include "TransportProfile.h"
 #include "gRpcExceptions.h"
 #include "logger.h"
+#include "recognition_streaming_request.pb.h"
 
 #include <cxxopts.hpp>
+#include <fstream>
+#include <sstream>
 
+namespace {
 
-Configuration::Configuration() : host("us.speechcenter.verbio.com"), language("en-US"),
-                                 sampleRate(8000) {}
+    // The values of a repeated -a, each one a whole path. cxxopts would split the values of a vector option on
+    // commas, which a file name may have.
+    struct AudioPaths {
+        std::vector<std::string> paths;
+    };
+
+    // Found by cxxopts through argument-dependent lookup.
+    void parse_value(const std::string &text, AudioPaths &value) {
+        value.paths.emplace_back(text);
+    }
+
+    std::vector<std::string> splitList(const std::string &list) {
+        std::vector<std::string> items;
+        std::stringstream stream(list);
+        std::string item;
+        while (std::getline(stream, item, ','))
+            if (!item.empty())
+                items.emplace_back(item);
+        return items;
+    }
+
+    // Parses a comma separated list of ports and inclusive port ranges, e.g. "40000-40009,41000".
+    std::vector<uint16_t> parsePorts(const std::string &list) {
+        std::vector<uint16_t> ports;
+        for (const auto &item: splitList(list)) {
+            auto dash = item.find('-');
+            try {
+                auto first = std::stoul(item.substr(0, dash));
+                auto last = dash == std::string::npos ? first : std::stoul(item.substr(dash + 1));
+                if (last > 65535 || first > last)
+                    throw std::out_of_range(item);
+                for (auto port = first; port <= last; ++port)
+                    ports.emplace_back(static_cast<uint16_t>(port));
+            } catch (const std::logic_error &) {
+                throw GrpcException("Invalid RTP port or port range '" + item + "'.");
+            }
+        }
+        return ports;
+    }
+
+    // Every topic of the recognition resource, which is what RecognitionClient::convertTopic accepts in any case.
+    std::vector<std::string> listTopics() {
+        const auto descriptor = speechcenter::recognizer::v1::RecognitionResource_Topic_descriptor();
+        std::vector<std::string> topics;
+        for (int i = 0; i < descriptor->value_count(); ++i)
+            topics.emplace_back(descriptor->value(i)->name());
+        return topics;
+    }
+
+    std::vector<std::string> readLines(const std::string &path) {
+        std::ifstream input(path);
+        if (!input)
+            throw IOError("Unable to open '" + path + "'");
+        std::vector<std::string> lines;
+        std::string line;
+        while (std::getline(input, line))
+            if (!line.empty() && line[0] != '#')
+                lines.emplace_back(line);
+        return lines;
+    }
+
+}
+
+
+Configuration::Configuration() : language("en-US"), readAhead(2), schedule("listed"), preflight("flag"),
+                                 host("us.speechcenter.verbio.com"), hosts{host}, hedging(false), probeInterval(5000),
+                                 transport("default"), sampleRate(8000), deadlineFactor(2.0), deadlineMargin(30),
+                                 jitterDelay(60), rtpIdleTimeout(3000), concurrency(1), warmUp(5000), quotaStreams(0),
+                                 quotaAudioRate(0) {}
 
 Configuration::Configuration(int argc, char **argv) : Configuration() {
     parse(argc, argv);
@@ -15,13 +87,26 @@ Configuration::Configuration(int argc, char **argv) : Configuration() {
 Configuration::~Configuration() = default;
 
 void Configuration::parse(int argc, char **argv) {
-    std::string grammarInline, grammarUri, grammarCompiled;
+    TraceSession::Scope traceScope(parseTrace.get());
+    std::string grammarInline, grammarUri, grammarCompiled, audioList, rtpPortList, candidateLanguageList,
+            candidateTopicList;
+    AudioPaths audioOptions;
 
     cxxopts::Options options(argv[0], "Verbio Technlogies S.L. - Speech Center client example");
     options.set_width(180).allow_unrecognised_options().add_options()
             ("a,audio",
-             "Path to a .wav audio in 8kHz or 16kHz sampling rate and PCM16 encoding to use for the recognition.",
-             cxxopts::value(audioPath), "file")
+             "Path to an audio in 8kHz or 16kHz sampling rate to use for the recognition: PCM16 .wav, .flac, or Ogg Vorbis/Opus. Can be repeated.",
+             cxxopts::value(audioOptions), "file")
+            ("audio-list", "File with one audio path per line to recognize one after another.",
+             cxxopts::value(audioList), "file")
+            ("read-ahead", "Number of audio files decoded in the background ahead of the one being streamed",
+             cxxopts::value<uint32_t>(readAhead)->default_value(std::to_string(readAhead)))
+            ("schedule", "Order in which the audio files are recognized: listed | longest-first. Higher priorities from --audio-list go first in both.",
+             cxxopts::value(schedule)->default_value(schedule))
+            ("preflight", "What to do with audio files that look silent, clipped, truncated, at the wrong rate or upsampled from 8 kHz: off | flag | skip. Flagged files are still recognized.",
+             cxxopts::value(preflight)->default_value(preflight))
+            ("preflight-report", "Write the pre-flight measures of every audio file to this tab separated file",
+             cxxopts::value(preflightReportPath), "file")
             ("I,inline-grammar", "ABNF Grammar to use for the recognition passed as a string.", cxxopts::value(grammarInline), "string")
             ("G,grammar-uri", "Grammar URI to use for the recognition (builtin or externally served).", cxxopts::value(grammarUri), "uri")
             ("C,compiled-grammar", "Path to the compiled grammar file (a .tar.xz file) to use for the recognition.", cxxopts::value(grammarCompiled), "file")
@@ -34,8 +119,14 @@ void Configuration::parse(int argc, char **argv) {
             ("s,sample-rate", "Sampling rate for the audio recognition: 8000, 16000.",
              cxxopts::value<uint32_t>(sampleRate)->default_value(std::to_string(sampleRate)))
             ("t,token", "Path to the authentication token file", cxxopts::value(tokenPath))
-            ("H,host", "URL of the Host or server trying to reach",
+            ("H,host", "URL of the Host or server trying to reach. A comma separated list routes each session to the fastest healthy host.",
              cxxopts::value(host)->default_value("us.speechcenter.verbio.com"))
+            ("hedge", "Stream each session to the two fastest hosts and keep the first one to answer",
+             cxxopts::value<bool>(hedging)->default_value("false"))
+            ("probe-interval", "Milliseconds between latency probes when several hosts are given (0 disables probing)",
+             cxxopts::value<uint32_t>(probeInterval)->default_value(std::to_string(probeInterval)))
+            ("transport", "gRPC transport profile: default | lan | wan | low-bandwidth. Sets flow-control windows, write buffering, message size and gzip of the audio.",
+             cxxopts::value(transport)->default_value(transport))
             ("S,not-secure", "Toggle for non-secure GRPC connections",
              cxxopts::value<bool>(notSecure)->default_value("false"))
             ("d,diarization", "Toggle for diarization", cxxopts::value<bool>(diarization)->default_value("false"))
@@ -44,6 +135,42 @@ void Configuration::parse(int argc, char **argv) {
             ("L,label", "Label for the request.", cxxopts::value(label)->default_value(""))
             ("client-id", "Client id for token refresh", cxxopts::value(clientId)->default_value(""))
             ("client-secret", "Client secret for token refresh", cxxopts::value(clientSecret)->default_value(""))
+            ("capture", "Record every request and response of the session, with timestamps, to this file for session_replay",
+             cxxopts::value(capturePath), "file")
+            ("trace", "Write a Chrome/Perfetto trace of the session stages to this file (needs a build with ENABLE_TRACING)",
+             cxxopts::value(tracePath), "file")
+            ("transcript-dir", "Write the words of every audio, with their times, confidences and speakers, to a binary transcript in this directory for transcript_query",
+             cxxopts::value(transcriptDirectory), "dir")
+            ("keywords", "Alert as soon as any phrase of this file, one per line, is heard, ignoring case and accents",
+             cxxopts::value(keywordsPath), "file")
+            ("cache-dir", "Directory of a local transcript cache. Audio already recognized with the same settings is answered from it without connecting.",
+             cxxopts::value(cacheDirectory), "dir")
+            ("deadline-factor", "Session deadline as a multiple of the audio duration, added to --deadline-margin",
+             cxxopts::value<double>(deadlineFactor)->default_value("2.0"))
+            ("deadline-margin", "Seconds added to every session deadline",
+             cxxopts::value<uint32_t>(deadlineMargin)->default_value("30"))
+            ("rtp-ports", "Recognize live G.711 RTP flows received on these UDP ports instead of audio files, e.g. 40000-40009",
+             cxxopts::value(rtpPortList), "ports")
+            ("jitter-delay", "Milliseconds a gap in an RTP flow is held open for reordered packets before it is concealed",
+             cxxopts::value<uint32_t>(jitterDelay)->default_value(std::to_string(jitterDelay)))
+            ("rtp-idle", "Milliseconds without packets after which an RTP flow, and its recognition, ends",
+             cxxopts::value<uint32_t>(rtpIdleTimeout)->default_value(std::to_string(rtpIdleTimeout)))
+            ("concurrency", "Maximum number of audio files recognized at the same time. The number actually in flight adapts to the server latency and pushback.",
+             cxxopts::value<uint32_t>(concurrency)->default_value(std::to_string(concurrency)))
+            ("metrics-file", "Export gauges such as the current concurrency limit to this file, in the Prometheus text format",
+             cxxopts::value(metricsPath), "file")
+            ("candidate-languages", "Comma separated languages to try at once on every audio when the language is unknown. The most confident one is kept after --warm-up.",
+             cxxopts::value(candidateLanguageList), "languages")
+            ("candidate-topics", "Comma separated topics to try at once on every audio, combined with --candidate-languages",
+             cxxopts::value(candidateTopicList), "topics")
+            ("warm-up", "Milliseconds of results used to score the candidates before all but the most confident are cancelled",
+             cxxopts::value<uint32_t>(warmUp)->default_value(std::to_string(warmUp)))
+            ("shared-quota", "Name of a shared memory quota that every client process of this host takes its streams and audio from",
+             cxxopts::value(sharedQuota), "name")
+            ("quota-streams", "Streams open at the same time across the processes sharing --shared-quota (0 for no limit)",
+             cxxopts::value<uint32_t>(quotaStreams)->default_value("0"))
+            ("quota-audio-rate", "Seconds of audio per second sent across the processes sharing --shared-quota (0 for no limit)",
+             cxxopts::value<double>(quotaAudioRate)->default_value("0"))
             ("h,help", "this help message");
     auto parsedOptions = options.parse(argc, argv);
 
@@ -67,6 +194,33 @@ void Configuration::parse(int argc, char **argv) {
         grammar = Grammar();
     }
 
+    audioPaths.insert(audioPaths.end(), audioOptions.paths.begin(), audioOptions.paths.end());
+    audioPriorities.assign(audioPaths.size(), 0);
+    if (!audioList.empty())
+        for (const auto &line: readLines(audioList)) {
+            // An optional priority follows the path after a tab.
+            const auto tab = line.rfind('\t');
+            audioPaths.emplace_back(line.substr(0, tab));
+            try {
+                audioPriorities.emplace_back(tab == std::string::npos ? 0 : std::stoi(line.substr(tab + 1)));
+            } catch (const std::logic_error &) {
+                throw GrpcException("Invalid priority in audio list line '" + line + "'.");
+            }
+        }
+    rtpPorts = parsePorts(rtpPortList);
+    if (audioPaths.empty() && rtpPorts.empty())
+        throw GrpcException("At least one audio or RTP port is needed.");
+    if (!audioPaths.empty())
+        audioPath = audioPaths.front();
+
+    candidateLanguages = splitList(candidateLanguageList);
+    candidateTopics = splitList(candidateTopicList);
+
+    hosts = splitList(host);
+    if (hosts.empty())
+        throw GrpcException("At least one host is needed.");
+    host = hosts.front();
+
     validate_configuration_values();
 }
 
@@ -74,10 +228,50 @@ std::string Configuration::getAudioPath() const {
     return audioPath;
 }
 
+std::vector<std::string> Configuration::getAudioPaths() const {
+    return audioPaths;
+}
+
+std::vector<int> Configuration::getAudioPriorities() const {
+    return audioPriorities;
+}
+
+std::string Configuration::getSchedule() const {
+    return schedule;
+}
+
+std::string Configuration::getPreflight() const {
+    return preflight;
+}
+
+std::string Configuration::getPreflightReportPath() const {
+    return preflightReportPath;
+}
+
+uint32_t Configuration::getReadAhead() const {
+    return readAhead;
+}
+
 std::string Configuration::getHost() const {
     return host;
 }
 
+std::vector<std::string> Configuration::getHosts() const {
+    return hosts;
+}
+
+bool Configuration::getHedging() const {
+    return hedging;
+}
+
+uint32_t Configuration::getProbeInterval() const {
+    return probeInterval;
+}
+
+std::string Configuration::getTransport() const {
+    return transport;
+}
+
 std::string Configuration::getLanguage() const {
     return language;
 }
@@ -134,6 +328,82 @@ std::string Configuration::getClientSecret()  const {
     return clientSecret;
 }
 
+std::string Configuration::getCapturePath() const {
+    return capturePath;
+}
+
+std::string Configuration::getTracePath() const {
+    return tracePath;
+}
+
+std::string Configuration::getTranscriptDirectory() const {
+    return transcriptDirectory;
+}
+
+std::string Configuration::getKeywordsPath() const {
+    return keywordsPath;
+}
+
+std::string Configuration::getCacheDirectory() const {
+    return cacheDirectory;
+}
+
+double Configuration::getDeadlineFactor() const {
+    return deadlineFactor;
+}
+
+uint32_t Configuration::getDeadlineMargin() const {
+    return deadlineMargin;
+}
+
+std::vector<uint16_t> Configuration::getRtpPorts() const {
+    return rtpPorts;
+}
+
+uint32_t Configuration::getJitterDelay() const {
+    return jitterDelay;
+}
+
+uint32_t Configuration::getRtpIdleTimeout() const {
+    return rtpIdleTimeout;
+}
+
+uint32_t Configuration::getConcurrency() const {
+    return concurrency;
+}
+
+std::string Configuration::getMetricsPath() const {
+    return metricsPath;
+}
+
+std::vector<std::string> Configuration::getCandidateLanguages() const {
+    return candidateLanguages;
+}
+
+std::vector<std::string> Configuration::getCandidateTopics() const {
+    return candidateTopics;
+}
+
+uint32_t Configuration::getWarmUp() const {
+    return warmUp;
+}
+
+std::string Configuration::getSharedQuota() const {
+    return sharedQuota;
+}
+
+uint32_t Configuration::getQuotaStreams() const {
+    return quotaStreams;
+}
+
+double Configuration::getQuotaAudioRate() const {
+    return quotaAudioRate;
+}
+
+TraceSession &Configuration::getParseTrace() const {
+    return *parseTrace;
+}
+
 void Configuration::validate_configuration_values() {
 
     if(sampleRate != 8000 and sampleRate != 16000) {
@@ -143,7 +413,16 @@ void Configuration::validate_configuration_values() {
     if (hasTopic())
         validate_string_value("topic", topic, allowedTopicValues);
     validate_string_value("language", language, allowedLanguageValues);
+    for (const auto &candidate: candidateLanguages)
+        validate_string_value("candidate language", candidate, allowedLanguageValues);
+    for (auto candidate: candidateTopics) {
+        std::transform(candidate.begin(), candidate.end(), candidate.begin(), ::toupper);
+        validate_string_value("candidate topic", candidate, listTopics());
+    }
     validate_string_value("asr version", asrVersion, allowedAsrVersionValues);
+    validate_string_value("schedule", schedule, allowedScheduleValues);
+    validate_string_value("preflight", preflight, allowedPreflightValues);
+    validate_string_value("transport", transport, TransportProfile::names());
 }
 
 
@@ -0,0 +1,112 @@
+#include "EndpointPool.h"
+
+#include "logger.h"
+
+#include <algorithm>
+#include <future>
+
+EndpointPool::EndpointPool(const std::vector<std::string> &hosts, ChannelFactory channelFactory,
+                           std::chrono::milliseconds probeInterval, std::chrono::milliseconds retryAfter) :
+        channelFactory(std::move(channelFactory)), probeInterval(probeInterval), retryAfter(retryAfter) {
+    for (const auto &host: hosts) {
+        auto endpoint = std::make_shared<Endpoint>(host);
+        endpoint->channel = this->channelFactory(host, false);
+        endpoints.emplace_back(endpoint);
+    }
+    if (endpoints.size() > 1) {
+        probeAll();
+        if (probeInterval.count() > 0)
+            prober = std::thread(&EndpointPool::probeLoop, this);
+    }
+}
+
+EndpointPool::~EndpointPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    stopCondition.notify_all();
+    if (prober.joinable())
+        prober.join();
+}
+
+std::vector<std::shared_ptr<Endpoint>> EndpointPool::rank() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto now = std::chrono::steady_clock::now();
+    for (const auto &endpoint: endpoints)
+        if (!endpoint->healthy && now >= endpoint->retryAt) {
+            INFO("Endpoint '{}' is tried again.", endpoint->host);
+            endpoint->healthy = true;
+        }
+    auto ranked = endpoints;
+    std::stable_sort(ranked.begin(), ranked.end(), [](const auto &a, const auto &b) {
+        if (a->healthy != b->healthy)
+            return a->healthy;
+        if (a->measured != b->measured)
+            return a->measured;
+        return a->rttMs < b->rttMs;
+    });
+    return ranked;
+}
+
+void EndpointPool::reportUnavailable(const std::shared_ptr<Endpoint> &endpoint) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (endpoint->healthy)
+        WARN("Endpoint '{}' marked as unavailable.", endpoint->host);
+    markUnavailable(*endpoint);
+}
+
+void EndpointPool::reportAvailable(const std::shared_ptr<Endpoint> &endpoint) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!endpoint->healthy)
+        INFO("Endpoint '{}' is available again.", endpoint->host);
+    endpoint->healthy = true;
+}
+
+void EndpointPool::probeLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopCondition.wait_for(lock, probeInterval, [this] { return stopping; })) {
+        lock.unlock();
+        probeAll();
+        lock.lock();
+    }
+}
+
+void EndpointPool::probeAll() {
+    std::vector<std::future<void>> probes;
+    for (const auto &endpoint: endpoints)
+        probes.emplace_back(std::async(std::launch::async, [this, endpoint] { probe(endpoint); }));
+    for (auto &probe: probes)
+        probe.get();
+}
+
+void EndpointPool::probe(const std::shared_ptr<Endpoint> &endpoint) {
+    auto channel = channelFactory(endpoint->host, true);
+    auto start = std::chrono::steady_clock::now();
+    bool connected = channel->WaitForConnected(std::chrono::system_clock::now() + probeTimeout);
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!connected) {
+        if (endpoint->healthy)
+            WARN("Endpoint '{}' did not connect within {}s, marked as unavailable.", endpoint->host, probeTimeout.count());
+        markUnavailable(*endpoint);
+        return;
+    }
+    if (!endpoint->healthy)
+        INFO("Endpoint '{}' is reachable again.", endpoint->host);
+    endpoint->healthy = true;
+    update(*endpoint, elapsed.count() / 1000.0);
+    DEBUG("Endpoint '{}' probed in {:.1f} ms (estimate {:.1f} ms)", endpoint->host, elapsed.count() / 1000.0,
+          endpoint->rttMs);
+}
+
+void EndpointPool::update(Endpoint &endpoint, double sampleMs) {
+    endpoint.rttMs = endpoint.measured ? (1 - smoothingFactor) * endpoint.rttMs + smoothingFactor * sampleMs : sampleMs;
+    endpoint.measured = true;
+}
+
+void EndpointPool::markUnavailable(Endpoint &endpoint) {
+    endpoint.healthy = false;
+    endpoint.retryAt = std::chrono::steady_clock::now() + retryAfter;
+}
@@ -0,0 +1,89 @@
+#include "G711.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define DECODER_TARGETS __attribute__((target_clones("avx2", "default")))
+#else
+#define DECODER_TARGETS
+#endif
+
+namespace {
+
+    constexpr int ulawBias = 0x84;
+    constexpr int ulawClip = 32635;
+    constexpr int segmentEnds[8] = {0xFF, 0x1FF, 0x3FF, 0x7FF, 0xFFF, 0x1FFF, 0x3FFF, 0x7FFF};
+
+    int segmentOf(int magnitude) {
+        int segment = 0;
+        while (segment < 8 && magnitude > segmentEnds[segment])
+            ++segment;
+        return segment;
+    }
+
+    // Negates value when negative is 1, leaves it untouched when it is 0.
+    inline int applySign(int value, int negative) {
+        return (value ^ -negative) + negative;
+    }
+
+}
+
+namespace g711 {
+
+    // The decoders need per-lane variable shifts, which x86 only has from AVX2 on, so they are also cloned for AVX2
+    // and the best version is picked at load time.
+    DECODER_TARGETS
+    void decodeUlaw(const uint8_t *__restrict codes, int16_t *__restrict samples, std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            const int code = ~codes[i] & 0xFF;
+            const int exponent = (code >> 4) & 0x07;
+            const int mantissa = code & 0x0F;
+            // Shifting through the upper half keeps the shift in 32-bit lanes; 16-bit variable shifts need AVX-512.
+            const int magnitude = ((((mantissa << 3) + ulawBias) << (exponent + 16)) >> 16) - ulawBias;
+            samples[i] = static_cast<int16_t>(applySign(magnitude, code >> 7));
+        }
+    }
+
+    DECODER_TARGETS
+    void decodeAlaw(const uint8_t *__restrict codes, int16_t *__restrict samples, std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            const int code = codes[i] ^ 0x55;
+            const int exponent = (code >> 4) & 0x07;
+            const int mantissa = code & 0x0F;
+            // Segment 0 is linear, the others carry an implicit leading bit and are shifted by exponent - 1.
+            const int segmented = exponent != 0;
+            const int magnitude = ((mantissa << 4) + 8 + (segmented << 8)) << (exponent - segmented);
+            // In A-law the sign bit is set for positive samples.
+            samples[i] = static_cast<int16_t>(applySign(magnitude, 1 - (code >> 7)));
+        }
+    }
+
+    uint8_t encodeUlaw(int16_t sample) {
+        int value = sample;
+        int mask = 0xFF;
+        if (value < 0) {
+            value = -value;
+            mask = 0x7F;
+        }
+        if (value > ulawClip)
+            value = ulawClip;
+        value += ulawBias;
+        const int segment = segmentOf(value);
+        if (segment >= 8)
+            return static_cast<uint8_t>(0x7F ^ mask);
+        return static_cast<uint8_t>(((segment << 4) | ((value >> (segment + 3)) & 0x0F)) ^ mask);
+    }
+
+    uint8_t encodeAlaw(int16_t sample) {
+        int value = sample;
+        int mask = 0xD5;
+        if (value < 0) {
+            value = -value - 8;
+            mask = 0x55;
+        }
+        const int segment = segmentOf(value);
+        if (segment >= 8)
+            return static_cast<uint8_t>(0x7F ^ mask);
+        const int shift = segment < 2 ? 4 : segment + 3;
+        return static_cast<uint8_t>(((segment << 4) | ((value >> shift) & 0x0F)) ^ mask);
+    }
+
+}
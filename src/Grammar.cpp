@@ -1,4 +1,5 @@
 #include "Grammar.h"
+#include "Tracing.h"
 
 #include <fstream>
 #include <filesystem>
@@ -26,6 +27,7 @@ std::vector<char> Grammar::getCompiledBytes() const {
 }
 
 void Grammar::readCompiledGrammar() {
+    TRACE_SCOPE("Grammar::readCompiledGrammar");
     if(!std::filesystem::exists(content)) {
         throw std::invalid_argument("Compiled grammar file '" + content + "' does not exist.");
     }
@@ -0,0 +1,84 @@
+#include "JitterBuffer.h"
+
+#include "logger.h"
+
+#include <algorithm>
+
+JitterBuffer::JitterBuffer(std::chrono::milliseconds delay) : delay(delay) {}
+
+int64_t JitterBuffer::extend(uint16_t sequence) const {
+    // The distance to the expected sequence number, taken modulo 2^16 in [-32768, 32767], survives the wrap-around.
+    return next + static_cast<int16_t>(static_cast<uint16_t>(sequence - static_cast<uint16_t>(next)));
+}
+
+void JitterBuffer::push(uint16_t sequence, std::vector<int16_t> samples, Clock::time_point arrival) {
+    ++statistics.received;
+    if (!started) {
+        started = true;
+        next = highest = sequence;
+    }
+    auto extended = extend(sequence);
+    if (extended - next > maxGap || next - extended > maxGap) {
+        WARN("RTP sequence jumped from {} to {}, restarting the jitter buffer.", next, sequence);
+        frames.clear();
+        next = highest = extended;
+    }
+    if (extended < next) {
+        ++statistics.late;
+        return;
+    }
+    if (extended < highest)
+        ++statistics.reordered;
+    if (!frames.emplace(extended, Frame{std::move(samples), arrival}).second) {
+        ++statistics.duplicates;
+        return;
+    }
+    highest = std::max(highest, extended);
+}
+
+void JitterBuffer::pop(Clock::time_point now, std::vector<int16_t> &output) {
+    while (!frames.empty()) {
+        auto first = frames.begin();
+        if (first->first != next && now < first->second.arrival + delay)
+            return;
+        conceal(first->first, first->second.samples.size(), output);
+        play(first->second, output);
+        frames.erase(first);
+    }
+}
+
+void JitterBuffer::flush(std::vector<int16_t> &output) {
+    for (auto first = frames.begin(); first != frames.end(); first = frames.erase(first)) {
+        conceal(first->first, first->second.samples.size(), output);
+        play(first->second, output);
+    }
+}
+
+JitterBuffer::Clock::time_point JitterBuffer::nextRelease() const {
+    if (frames.empty())
+        return Clock::time_point::max();
+    return frames.begin()->second.arrival + delay;
+}
+
+const JitterBuffer::Statistics &JitterBuffer::getStatistics() const {
+    return statistics;
+}
+
+void JitterBuffer::play(Frame &frame, std::vector<int16_t> &output) {
+    output.insert(output.end(), frame.samples.begin(), frame.samples.end());
+    lastFrame = std::move(frame.samples);
+    lostInRow = 0;
+    ++next;
+}
+
+void JitterBuffer::conceal(int64_t until, std::size_t frameSize, std::vector<int16_t> &output) {
+    if (lastFrame.empty())
+        lastFrame.assign(frameSize, 0);
+    for (; next < until; ++next) {
+        ++statistics.concealed;
+        ++lostInRow;
+        const float gain = std::max(0, fadeFrames - lostInRow) / static_cast<float>(fadeFrames);
+        for (auto sample: lastFrame)
+            output.emplace_back(static_cast<int16_t>(sample * gain));
+    }
+}
@@ -0,0 +1,32 @@
+#include "JobScheduler.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+JobScheduler::JobScheduler(std::size_t slots, Order order) : slots(std::max<std::size_t>(slots, 1)), order(order) {}
+
+std::vector<JobScheduler::Job> JobScheduler::schedule(std::vector<Job> jobs) const {
+    std::stable_sort(jobs.begin(), jobs.end(), [this](const Job &a, const Job &b) {
+        if (a.priority != b.priority)
+            return a.priority > b.priority;
+        return order == Order::LongestFirst && a.duration > b.duration;
+    });
+    return jobs;
+}
+
+std::chrono::microseconds JobScheduler::predictMakespan(const std::vector<Job> &jobs) const {
+    // Times at which each busy slot frees up, earliest on top.
+    std::priority_queue<std::chrono::microseconds, std::vector<std::chrono::microseconds>,
+            std::greater<>> freeAt;
+    for (std::size_t i = 0; i < slots; ++i)
+        freeAt.emplace(0);
+    std::chrono::microseconds makespan{0};
+    for (const auto &job: jobs) {
+        const auto end = freeAt.top() + job.duration;
+        freeAt.pop();
+        freeAt.push(end);
+        makespan = std::max(makespan, end);
+    }
+    return makespan;
+}
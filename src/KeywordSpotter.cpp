@@ -0,0 +1,230 @@
+#include "KeywordSpotter.h"
+
+#include "gRpcExceptions.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <queue>
+#include <unordered_set>
+
+using namespace speechcenter::recognizer::v1;
+
+namespace {
+
+    // Folding covers only the two tables below, Latin-1 Supplement and Latin Extended-A, which hold the accented
+    // letters of the Western and Central European languages. Anything else, such as the Latin Extended-B and
+    // Vietnamese letters, decomposed accents or non-Latin scripts, is kept byte for byte, neither stripped of its
+    // accents nor lowercased, so a phrase only matches it written the same way.
+
+    // Latin-1 Supplement letters from U+00C0 without their accents, empty for × and ÷.
+    const char *const latin1[64] = {
+            "a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+            "d", "n", "o", "o", "o", "o", "o", "", "o", "u", "u", "u", "u", "y", "th", "ss",
+            "a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+            "d", "n", "o", "o", "o", "o", "o", "", "o", "u", "u", "u", "u", "y", "th", "y"};
+
+    // Latin Extended-A, U+0100 to U+017F, by ranges of the same base letter.
+    struct Range {
+        char32_t last;
+        const char *letters;
+    };
+
+    const Range latinExtendedA[] = {
+            {0x105, "a"}, {0x10d, "c"}, {0x111, "d"}, {0x11b, "e"}, {0x123, "g"}, {0x127, "h"},
+            {0x131, "i"}, {0x133, "ij"}, {0x135, "j"}, {0x138, "k"}, {0x142, "l"}, {0x14b, "n"},
+            {0x151, "o"}, {0x153, "oe"}, {0x159, "r"}, {0x161, "s"}, {0x167, "t"}, {0x173, "u"},
+            {0x175, "w"}, {0x178, "y"}, {0x17e, "z"}, {0x17f, "s"}};
+
+    // Reads the code point at position and moves past it; malformed bytes read as a single U+FFFD.
+    char32_t decode(const std::string &text, std::size_t &position) {
+        auto lead = static_cast<unsigned char>(text[position++]);
+        if (lead < 0x80)
+            return lead;
+        std::size_t continuation = lead >= 0xf0 && lead < 0xf8 ? 3 : lead >= 0xe0 ? 2 : lead >= 0xc0 ? 1 : 0;
+        if (continuation == 0 || lead >= 0xf8 || position + continuation > text.size())
+            return 0xfffd;
+        char32_t codePoint = lead & (0x3f >> continuation);
+        for (std::size_t i = 0; i < continuation; ++i) {
+            auto byte = static_cast<unsigned char>(text[position + i]);
+            if ((byte & 0xc0) != 0x80)
+                return 0xfffd;
+            codePoint = codePoint << 6 | (byte & 0x3f);
+        }
+        position += continuation;
+        return codePoint;
+    }
+
+    bool isSeparator(char32_t codePoint) {
+        if (codePoint < 0x80)
+            return !std::isalnum(static_cast<int>(codePoint));
+        // Latin-1 punctuation such as ¿ ¡ « », general punctuation such as ’ “ …, and malformed bytes.
+        return codePoint < 0xc0 || codePoint == 0xd7 || codePoint == 0xf7 ||
+               (codePoint >= 0x2000 && codePoint <= 0x206f) || codePoint == 0xfffd;
+    }
+
+    void appendFolded(std::string &word, const std::string &text, std::size_t from, std::size_t to,
+                      char32_t codePoint) {
+        if (codePoint < 0x80)
+            word.push_back(static_cast<char>(std::tolower(static_cast<int>(codePoint))));
+        else if (codePoint >= 0xc0 && codePoint < 0x100)
+            word += latin1[codePoint - 0xc0];
+        else if (codePoint >= 0x100 && codePoint < 0x180)
+            word += std::find_if(std::begin(latinExtendedA), std::end(latinExtendedA),
+                                 [codePoint](const Range &range) { return codePoint <= range.last; })->letters;
+        else
+            word.append(text, from, to - from);
+    }
+
+    std::vector<std::string> readPhrases(const std::string &path) {
+        std::ifstream file(path);
+        if (!file)
+            throw IOError("Unable to open keywords '" + path + "'");
+        std::vector<std::string> phrases;
+        std::string line;
+        while (std::getline(file, line)) {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (!line.empty() && line[0] != '#')
+                phrases.push_back(line);
+        }
+        return phrases;
+    }
+
+}
+
+KeywordAutomaton::KeywordAutomaton(const std::vector<std::string> &phraseList) {
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> children(1);
+    matches.emplace_back();
+    std::unordered_set<uint32_t> phraseStates;
+    for (const auto &phrase: phraseList) {
+        auto tokens = tokenize(phrase);
+        if (tokens.empty())
+            continue;
+        uint32_t state = root;
+        for (const auto &token: tokens) {
+            auto word = words.emplace(token, static_cast<uint32_t>(words.size())).first->second;
+            auto next = transitions.emplace(edge(state, word), static_cast<uint32_t>(children.size()));
+            if (next.second) {
+                children[state].emplace_back(word, next.first->second);
+                children.emplace_back();
+                matches.emplace_back();
+            }
+            state = next.first->second;
+        }
+        // The same words twice, e.g. differing only in case, are one phrase.
+        if (!phraseStates.insert(state).second)
+            continue;
+        matches[state].push_back(static_cast<uint32_t>(phrases.size()));
+        phrases.push_back(phrase);
+        lengths.push_back(static_cast<uint32_t>(tokens.size()));
+    }
+
+    // Breadth first, so the failure of every state is complete before its children need it.
+    failures.assign(children.size(), root);
+    std::queue<uint32_t> pending;
+    for (const auto &child: children[root])
+        pending.push(child.second);
+    while (!pending.empty()) {
+        auto state = pending.front();
+        pending.pop();
+        for (const auto &child: children[state]) {
+            auto failure = follow(failures[state], child.first);
+            failures[child.second] = failure;
+            const auto &inherited = matches[failure];
+            matches[child.second].insert(matches[child.second].end(), inherited.begin(), inherited.end());
+            pending.push(child.second);
+        }
+    }
+}
+
+std::shared_ptr<const KeywordAutomaton> KeywordAutomaton::load(const std::string &path) {
+    return std::make_shared<const KeywordAutomaton>(readPhrases(path));
+}
+
+std::vector<std::string> KeywordAutomaton::tokenize(const std::string &text) {
+    std::vector<std::string> tokens;
+    std::string word;
+    std::size_t position = 0;
+    while (position < text.size()) {
+        auto from = position;
+        auto codePoint = decode(text, position);
+        if (isSeparator(codePoint)) {
+            if (!word.empty())
+                tokens.push_back(std::move(word));
+            word.clear();
+        } else
+            appendFolded(word, text, from, position, codePoint);
+    }
+    if (!word.empty())
+        tokens.push_back(std::move(word));
+    return tokens;
+}
+
+std::size_t KeywordAutomaton::countPhrases() const {
+    return phrases.size();
+}
+
+const std::string &KeywordAutomaton::getPhrase(uint32_t phrase) const {
+    return phrases[phrase];
+}
+
+uint32_t KeywordAutomaton::getLength(uint32_t phrase) const {
+    return lengths[phrase];
+}
+
+uint32_t KeywordAutomaton::step(uint32_t state, const std::string &word) const {
+    auto known = words.find(word);
+    return known == words.end() ? root : follow(state, known->second);
+}
+
+const std::vector<uint32_t> &KeywordAutomaton::getMatches(uint32_t state) const {
+    return matches[state];
+}
+
+uint32_t KeywordAutomaton::follow(uint32_t state, uint32_t word) const {
+    while (true) {
+        auto next = transitions.find(edge(state, word));
+        if (next != transitions.end())
+            return next->second;
+        if (state == root)
+            return root;
+        state = failures[state];
+    }
+}
+
+KeywordSpotter::KeywordSpotter(std::shared_ptr<const KeywordAutomaton> automaton, HitListener listener) :
+        automaton(std::move(automaton)), listener(std::move(listener)) {}
+
+void KeywordSpotter::onResult(const RecognitionResult &result) {
+    if (result.alternatives().empty())
+        return;
+    const auto &alternative = result.alternatives(0);
+    std::vector<Token> tokens;
+    if (alternative.words().empty())
+        for (auto &word: KeywordAutomaton::tokenize(alternative.transcript()))
+            tokens.push_back({std::move(word), 0, 0, 0});
+    else
+        // A recognized word may still hold several, e.g. with an apostrophe, and each keeps its timing.
+        for (const auto &info: alternative.words())
+            for (auto &word: KeywordAutomaton::tokenize(info.word()))
+                tokens.push_back({std::move(word), info.start_time(), info.end_time(), info.speaker_id()});
+
+    std::unordered_map<uint32_t, std::size_t> occurrences;
+    auto state = KeywordAutomaton::root;
+    for (std::size_t last = 0; last < tokens.size(); ++last) {
+        state = automaton->step(state, tokens[last].word);
+        for (auto phrase: automaton->getMatches(state)) {
+            auto occurrence = ++occurrences[phrase];
+            auto &alreadyReported = reported[phrase];
+            if (occurrence <= alreadyReported)
+                continue;
+            alreadyReported = occurrence;
+            const auto &first = tokens[last + 1 - automaton->getLength(phrase)];
+            listener({automaton->getPhrase(phrase), first.startTime, tokens[last].endTime, first.speaker,
+                      result.is_final()});
+        }
+    }
+    if (result.is_final())
+        reported.clear();
+}
@@ -0,0 +1,38 @@
+#include "LiveAudio.h"
+
+#include <algorithm>
+
+LiveAudio::LiveAudio(uint32_t sampleRate, std::chrono::milliseconds chunkDuration) :
+        sampleRate(sampleRate), chunkSamples(std::max<std::size_t>(1, sampleRate * chunkDuration.count() / 1000)) {}
+
+void LiveAudio::push(const int16_t *samples, std::size_t count) {
+    if (count == 0)
+        return;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (closed)
+        return;
+    buffered.insert(buffered.end(), samples, samples + count);
+    if (buffered.size() >= chunkSamples)
+        changed.notify_all();
+}
+
+void LiveAudio::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+    changed.notify_all();
+}
+
+bool LiveAudio::pop(std::string &chunk) {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this] { return closed || buffered.size() >= chunkSamples; });
+    if (buffered.empty())
+        return false;
+    const auto count = std::min(buffered.size(), chunkSamples);
+    chunk.assign(reinterpret_cast<const char *>(buffered.data()), count * sizeof(int16_t));
+    buffered.erase(buffered.begin(), buffered.begin() + static_cast<long>(count));
+    return true;
+}
+
+uint32_t LiveAudio::getSampleRate() const {
+    return sampleRate;
+}
@@ -0,0 +1,28 @@
+#include "MetricsFile.h"
+
+#include "gRpcExceptions.h"
+
+#include <cstdio>
+#include <fstream>
+
+MetricsFile::MetricsFile(std::string path) : path(std::move(path)) {}
+
+void MetricsFile::set(const std::string &name, const std::string &help, double value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    gauges[name] = {help, value};
+}
+
+void MetricsFile::write() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto temporary = path + ".tmp";
+    {
+        std::ofstream output(temporary, std::ios::trunc);
+        if (!output)
+            throw IOError("Unable to write metrics to '" + temporary + "'");
+        for (const auto &[name, gauge]: gauges)
+            output << "# HELP " << name << ' ' << gauge.help << "\n# TYPE " << name << " gauge\n"
+                   << name << ' ' << gauge.value << '\n';
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0)
+        throw IOError("Unable to replace metrics file '" + path + "'");
+}
@@ -10,9 +10,7 @@
 #include <grpcpp/create_channel.h>
 
 #include <chrono>
-#include <future>
 #include <sstream>
-#include <thread>
 
 using namespace speechcenter::recognizer::v1;
 typedef RecognitionStreamingRequest Request;
@@ -34,43 +32,6 @@ namespace {
 
 }
 
-void RecognitionClient::write(
-        std::shared_ptr<grpc::ClientReaderWriter<Request,
-                Response>>
-        stream) {
-
-    INFO("Writing to stream...");
-    Request recognitionConfig = buildRecognitionConfig();
-    INFO("Sending config: \n{} ", buildLogString(recognitionConfig));
-    bool streamFail = !stream->Write(recognitionConfig);
-    if (streamFail) {
-        auto status = stream->Finish();
-        ERROR("{} ({}: {})", status.error_message(), status.error_code(), status.error_details());
-        throw StreamException(status.error_message());
-    }
-
-    INFO("Sending audio...");
-    int requestCount = 0;
-    for (const auto &request: buildAudioRequests()) {
-        constexpr int bytesPerSamples = 2;// PCM16
-        auto deadline = std::chrono::system_clock::now() +
-                        std::chrono::milliseconds(
-                                request.audio().length() * 1000 / (bytesPerSamples * configuration.getSampleRate()));
-        if (!stream->Write(request)) {
-            auto status = stream->Finish();
-            ERROR("{} (GRPC_ERR_CODE {} - {})", status.error_message(), status.error_code(), status.error_details());
-            throw StreamException(status.error_message());
-        }
-        ++requestCount;
-        if (requestCount % 10 == 0)
-            INFO("Sent {} bytes of audio", requestCount * request.audio().length());
-
-        std::this_thread::sleep_until(deadline);
-    }
-    stream->WritesDone();
-    INFO("All audio sent in {} requests.", requestCount);
-}
-
 std::string uppercaseString(const std::string &str) {
     std::locale loc;
     std::string upper = "";
@@ -82,19 +43,43 @@ std::string uppercaseString(const std::string &str) {
 RecognitionClient::RecognitionClient(const Configuration &configuration) {
     INFO("Started recognition session...");
     this->configuration = configuration;
-    channel = createChannel();
-    stub_ = Recognizer::NewStub(channel);
+    TraceSession::Scope traceScope(&setupTrace);
+    setupTrace.merge(this->configuration.getParseTrace());
+    jwt = getJwtToken();
+    transport = &TransportProfile::byName(configuration.getTransport());
+    INFO("Transport profile '{}'", transport->name);
+    endpointPool = std::make_unique<EndpointPool>(
+            configuration.getHosts(),
+            [this](const std::string &host, bool probe) { return createChannel(host, probe); },
+            std::chrono::milliseconds(configuration.getProbeInterval()));
+    if (!configuration.getSharedQuota().empty())
+        quota = std::make_unique<SharedQuota>(
+                configuration.getSharedQuota(),
+                SharedQuota::Limits{configuration.getQuotaStreams(), configuration.getQuotaAudioRate()});
 };
 
 RecognitionClient::~RecognitionClient() = default;
 
-std::shared_ptr<grpc::Channel> RecognitionClient::createChannel() {
-    std::string jwt = getJwtToken();
-    establishConnection(jwt);
-    return getReadyChannel();
+std::shared_ptr<grpc::Channel> RecognitionClient::createChannel(const std::string &host, bool probe) const {
+    grpc::ChannelArguments arguments;
+    transport->apply(arguments);
+    if (probe) {
+        // A private subchannel pool forces a fresh connection, so the probe measures a real handshake.
+        arguments.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+        return establishConnection(host, arguments);
+    }
+    if (configuration.getHosts().size() > 1) {
+        // Connects in the background. The pool probes all the hosts at once, so a host that is down costs one probe
+        // timeout instead of holding up the start of the client while every host is waited for in turn.
+        auto channel = establishConnection(host, arguments);
+        channel->GetState(true);
+        return channel;
+    }
+    return getReadyChannel(establishConnection(host, arguments));
 }
 
-std::shared_ptr<grpc::Channel> RecognitionClient::getReadyChannel() const {
+std::shared_ptr<grpc::Channel> RecognitionClient::getReadyChannel(const std::shared_ptr<grpc::Channel> &channel) {
+    TRACE_SCOPE("getReadyChannel");
     channel->WaitForConnected(std::chrono::system_clock::now() +
                               std::chrono::seconds(5));
     if (channel->GetState(false) != GRPC_CHANNEL_READY)
@@ -109,23 +94,29 @@ std::shared_ptr<grpc::Channel> RecognitionClient::getReadyChannel() const {
     return channel;
 }
 
-void RecognitionClient::establishConnection(const std::string &jwt) {
+std::shared_ptr<grpc::Channel> RecognitionClient::establishConnection(const std::string &host,
+                                                                      const grpc::ChannelArguments &arguments) const {
     if (configuration.getNotSecure()) {
-        WARN("Establishing insecure connection.");
-        channel = grpc::CreateChannel(configuration.getHost(),
-                                      grpc::InsecureChannelCredentials());
-        context.AddMetadata("authorization", "Bearer" + jwt);
-    } else {
-        INFO( "Establishing secure connection.");
-        channel = grpc::CreateChannel(
-                configuration.getHost(),
-                grpc::CompositeChannelCredentials(
-                        grpc::SslCredentials(grpc::SslCredentialsOptions()),
-                        grpc::AccessTokenCredentials(jwt)));
+        WARN("Establishing insecure connection to '{}'.", host);
+        return grpc::CreateCustomChannel(host, grpc::InsecureChannelCredentials(), arguments);
     }
+    INFO("Establishing secure connection to '{}'.", host);
+    return grpc::CreateCustomChannel(
+            host,
+            grpc::CompositeChannelCredentials(
+                    grpc::SslCredentials(grpc::SslCredentialsOptions()),
+                    grpc::AccessTokenCredentials(jwt)),
+            arguments);
+}
+
+void RecognitionClient::prepareContext(grpc::ClientContext &context) const {
+    transport->apply(context);
+    if (configuration.getNotSecure())
+        context.AddMetadata("authorization", "Bearer" + jwt);
 }
 
 std::string RecognitionClient::getJwtToken() const {
+    TRACE_SCOPE("getJwtToken");
     auto speechCenterCredentials = SpeechCenterCredentials(configuration.getTokenPath());
     if (!configuration.getClientId().empty() && !configuration.getClientSecret().empty()) {
         INFO("Automatic token refresh enabled. Writing new tokens to file: '{}'", configuration.getTokenPath());
@@ -135,53 +126,71 @@ std::string RecognitionClient::getJwtToken() const {
 }
 
 void RecognitionClient::performStreamingRecognition() {
-    std::shared_ptr<grpc::ClientReaderWriter<Request, Response>> stream(stub_->StreamingRecognize(&context));
-    INFO("Stream created. State {}", channel->GetState(true));
+    createSession(prepareAudio(std::make_shared<const Audio>(configuration.getAudioPath())))->run();
+}
+
+void RecognitionClient::performStreamingRecognition(const Audio &audio, const ResultListener &listener) {
+    createSession(audio, listener)->run();
+}
 
-    stream = bidirectionalStream(stream);
+std::unique_ptr<RecognitionSession> RecognitionClient::createSession(const Audio &audio, const ResultListener &listener) {
+    return createSession(prepareAudio(audio), listener);
+}
 
-    grpc::Status status = stream->Finish();
-    if (!status.ok()) {
-        ERROR("RESPONSE ERROR!\n\n");
-        throw StreamException(status.error_message());
+std::shared_ptr<const AudioRequests> RecognitionClient::prepareAudio(std::shared_ptr<const Audio> audio) {
+    auto requests = std::make_shared<AudioRequests>();
+    requests->trace.merge(audio->getTrace());
+    {
+        TraceSession::Scope traceScope(&requests->trace);
+        requests->chunks = buildAudioRequests(audio);
     }
+    requests->duration = std::chrono::microseconds(audio->getLengthInFrames() * 1000000 / audio->getSamplingRate());
+    return requests;
+}
+
+std::shared_ptr<const AudioRequests> RecognitionClient::prepareAudio(const Audio &audio) {
+    return prepareAudio(std::make_shared<const Audio>(audio.getData(), audio.getSamplingRate(),
+                                                      audio.getLengthInFrames()));
 }
 
-std::shared_ptr<grpc::ClientReaderWriter<Request, Response>> &
-RecognitionClient::bidirectionalStream(std::shared_ptr<grpc::ClientReaderWriter<Request, Response>> &stream) {
-    std::packaged_task<void(
-            std::shared_ptr<grpc::ClientReaderWriter<Request, Response>>)>
-            parallel_write(
-            [this](
-                    std::shared_ptr<grpc::ClientReaderWriter<Request, Response>> stream) { write(stream); });
-    auto result = parallel_write.get_future();
-    auto thread = std::thread{std::move(parallel_write), stream};
-
-    readFromStream(stream);
-
-    thread.join();
-    result.get();
-    return stream;
+std::unique_ptr<RecognitionSession> RecognitionClient::createSession(std::shared_ptr<const AudioRequests> audio,
+                                                                     const ResultListener &listener,
+                                                                     const SessionOptions &options) {
+    auto config = buildRecognitionConfig();
+    if (!options.language.empty())
+        config.mutable_config()->mutable_parameters()->set_language(options.language);
+    if (!options.topic.empty())
+        config.mutable_config()->mutable_resource()->set_topic(convertTopic(options.topic));
+    INFO("Sending config: \n{} ", buildLogString(config));
+
+    auto timeout = std::chrono::duration_cast<std::chrono::microseconds>(
+            audio->duration * configuration.getDeadlineFactor() + std::chrono::seconds(configuration.getDeadlineMargin()));
+    return std::make_unique<RecognitionSession>(*this, sessionCount++, std::move(config), std::move(audio), timeout,
+                                                listener, options.printResults, options.chargeAudioQuota);
 }
 
-void RecognitionClient::readFromStream(std::shared_ptr<grpc::ClientReaderWriter<Request, Response>> &stream) const {
-
-    INFO("Reading from stream...");
-    Response response;
-    while (stream->Read(&response)) {
-        if (response.result().is_final() &&
-            !response.result().alternatives().empty()) {
-            RecognitionAlternative firstAlternative =
-                    response.result().alternatives().Get(0);
-            if (firstAlternative.words_size() > 0) {
-                INFO("Segment start: {}", firstAlternative.words()[0].start_time());
-                std::cout << firstAlternative.transcript() << std::endl;
-                INFO("Segment end: {}",
-                     firstAlternative.words()[firstAlternative.words_size() - 1].end_time());
-            }
-        } else {
-            WARN("No recognition result alternatives!");
+std::unique_ptr<RecognitionSession> RecognitionClient::createLiveSession(std::shared_ptr<LiveAudio> audio,
+                                                                         const ResultListener &listener) {
+    auto config = buildRecognitionConfig();
+    config.mutable_config()->mutable_parameters()->mutable_pcm()->set_sample_rate_hz(audio->getSampleRate());
+    return std::make_unique<RecognitionSession>(*this, sessionCount++, std::move(config), std::move(audio), listener);
+}
+
+void RecognitionClient::printResult(const RecognitionResult &result) {
+    // Interim hypotheses are only for listeners, e.g. a TranscriptTimeline.
+    if (!result.is_final())
+        return;
+    if (!result.alternatives().empty()) {
+        const RecognitionAlternative &firstAlternative =
+                result.alternatives(0);
+        if (firstAlternative.words_size() > 0) {
+            INFO("Segment start: {}", firstAlternative.words(0).start_time());
+            std::cout << firstAlternative.transcript() << std::endl;
+            INFO("Segment end: {}",
+                 firstAlternative.words(firstAlternative.words_size() - 1).end_time());
         }
+    } else {
+        WARN("No recognition result alternatives!");
     }
 }
 
@@ -204,19 +213,24 @@ Request RecognitionClient::buildRecognitionConfig() {
     return recognitionConfig;
 }
 
-std::vector<Request> RecognitionClient::buildAudioRequests() {
+std::vector<wire::Frame> RecognitionClient::buildAudioRequests(const std::shared_ptr<const Audio> &audio) {
+    TRACE_SCOPE("buildAudioRequests");
     INFO("Building audio request...");
-    std::string path = configuration.getAudioPath();
-    auto const &audio = Audio(path);
-    int64_t lengthInBytes = audio.getLengthInBytes();
+    int64_t lengthInBytes = audio->getLengthInBytes();
     INFO("Audio bytes: " + std::to_string(lengthInBytes));
 
-    std::vector<Request> requests;
-    auto chunks = audio.getAudioChunks<20000>();
-    for (const auto &chunk: chunks) {
-        Request request;
-        request.set_audio(static_cast<const void *>(chunk.data()), chunk.size() * audio.getBytesPerSamples());
-        requests.emplace_back(request);
+    constexpr int64_t chunkLength = 20000;
+    const auto chunkBytes = static_cast<std::size_t>(chunkLength * audio->getBytesPerSamples());
+    std::vector<wire::Frame> requests;
+    int64_t offset = 0;
+    for (; offset + chunkLength <= audio->getLengthInFrames(); offset += chunkLength)
+        requests.emplace_back(wire::audioFrame(audio->getData() + offset, chunkBytes, audio));
+    // Only the last chunk is copied, to pad it with silence to a full one.
+    if (offset < audio->getLengthInFrames()) {
+        std::string last(chunkBytes, '\0');
+        std::copy_n(reinterpret_cast<const char *>(audio->getData() + offset),
+                    (audio->getLengthInFrames() - offset) * audio->getBytesPerSamples(), last.begin());
+        requests.emplace_back(wire::audioFrame(std::move(last)));
     }
     return requests;
 }
@@ -260,27 +274,15 @@ RecognitionClient::buildRecognitionResource() {
 
 RecognitionResource_Topic
 RecognitionClient::convertTopic(const std::string &topicName) {
-    static const std::unordered_map<
-            std::string, RecognitionResource_Topic>
-            validTopics = {
-            {"GENERIC",
-                    RecognitionResource_Topic_GENERIC},
-            {"BANKING",
-                    RecognitionResource_Topic_BANKING},
-            {"TELCO",
-                    RecognitionResource_Topic_TELCO},
-            {"INSURANCE",
-                    RecognitionResource_Topic_INSURANCE}};
-
     std::string topicUpper = uppercaseString(topicName);
 
-    auto topicIter = validTopics.find(topicUpper);
-    if (topicIter == validTopics.end()) {
+    RecognitionResource_Topic topic;
+    if (!RecognitionResource_Topic_Parse(topicUpper, &topic)) {
         ERROR("Unsupported topic: {}", topicName);
         throw UnknownTopicModel(topicUpper);
     }
 
-    return topicIter->second;
+    return topic;
 }
 
 GrammarResource*
@@ -0,0 +1,493 @@
+#include "RecognitionSession.h"
+
+#include "RecognitionClient.h"
+#include "ResponseArena.h"
+#include "gRpcExceptions.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <future>
+#include <thread>
+
+using namespace speechcenter::recognizer::v1;
+
+RecognitionSession::Attempt::Attempt(RecognitionSession &session, std::shared_ptr<Endpoint> endpoint,
+                                     SharedQuota::Lease slot) :
+        slot(std::move(slot)), session(&session), endpoint(std::move(endpoint)),
+        context(std::make_unique<grpc::ClientContext>()) {
+    std::lock_guard<std::mutex> lock(session.mutex);
+    session.activeContexts.emplace_back(context.get());
+    if (session.cancelRequested)
+        context->TryCancel();
+}
+
+RecognitionSession::Attempt::~Attempt() {
+    if (!context)
+        return;
+    std::lock_guard<std::mutex> lock(session->mutex);
+    auto &contexts = session->activeContexts;
+    contexts.erase(std::remove(contexts.begin(), contexts.end(), context.get()), contexts.end());
+}
+
+RecognitionSession::RecognitionSession(RecognitionClient &client, int index, Request config,
+                                       std::shared_ptr<const AudioRequests> audio, std::chrono::microseconds timeout,
+                                       ResultListener listener, bool printResults, bool chargeAudioQuota) :
+        client(client), index(index), config(wire::serialize(config)), audio(std::move(audio)), timeout(timeout),
+        listener(std::move(listener)), printResults(printResults), chargeAudioQuota(chargeAudioQuota) {}
+
+RecognitionSession::RecognitionSession(RecognitionClient &client, int index, Request config,
+                                       std::shared_ptr<LiveAudio> live, ResultListener listener) :
+        client(client), index(index), config(wire::serialize(config)), timeout(0), live(std::move(live)),
+        listener(std::move(listener)) {}
+
+RecognitionSession::~RecognitionSession() = default;
+
+void RecognitionSession::run() {
+    trace.merge(client.setupTrace);
+    if (audio)
+        trace.merge(audio->trace);
+    try {
+        TraceSession::Scope traceScope(&trace);
+        recognize();
+    } catch (...) {
+        audio.reset();
+        writeTrace();
+        if (isCancelled()) {
+            INFO("Session {} cancelled.", index);
+            return;
+        }
+        throw;
+    }
+    audio.reset();
+    writeTrace();
+}
+
+void RecognitionSession::cancel() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (cancelRequested)
+        return;
+    cancelRequested = true;
+    for (auto context: activeContexts)
+        context->TryCancel();
+    cancelled.notify_all();
+    if (live)
+        live->close();
+}
+
+bool RecognitionSession::isCancelled() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return cancelRequested;
+}
+
+grpc::StatusCode RecognitionSession::getStatusCode() const {
+    return statusCode;
+}
+
+std::chrono::microseconds RecognitionSession::getFinalLatency() const {
+    return finalLatency;
+}
+
+std::chrono::microseconds RecognitionSession::getAudioSent() const {
+    return audioSent;
+}
+
+std::string RecognitionSession::sessionPath(const std::string &path) const {
+    return index == 0 ? path : path + "." + std::to_string(index);
+}
+
+void RecognitionSession::writeTrace() const {
+    if (client.configuration.getTracePath().empty())
+        return;
+    if (!tracingEnabled)
+        WARN("Tracing is not available in this build, configure it with -DENABLE_TRACING=ON.");
+    trace.write(sessionPath(client.configuration.getTracePath()));
+}
+
+void RecognitionSession::recognize() {
+    if (client.quota && audio && chargeAudioQuota && !client.quota->acquireAudio(
+            audio->duration, [this](std::chrono::milliseconds duration) { return waitForQuota(duration); }))
+        throw StreamException("Cancelled while waiting for the shared audio quota.");
+    auto endpoints = client.endpointPool->rank();
+    std::size_t next = 0;
+    if (client.configuration.getHedging() && endpoints.size() > 1) {
+        try {
+            hedgedStream({endpoints[0], endpoints[1]});
+            return;
+        } catch (const EndpointUnavailable &e) {
+            WARN("{}", e.what());
+        }
+        next = 2;
+    }
+    for (; next < endpoints.size() && !isCancelled(); ++next) {
+        try {
+            streamOn(endpoints[next]);
+            return;
+        } catch (const EndpointUnavailable &e) {
+            WARN("{}", e.what());
+        }
+    }
+    throw StreamException("No endpoint available.");
+}
+
+bool RecognitionSession::waitForQuota(std::chrono::milliseconds duration) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return !cancelled.wait_for(lock, duration, [this] { return cancelRequested; });
+}
+
+bool RecognitionSession::takeStreamSlot(SharedQuota::Lease &slot, bool wait) {
+    if (!client.quota)
+        return true;
+    TRACE_SCOPE("acquireStream");
+    slot = client.quota->acquireStream([this, wait](std::chrono::milliseconds duration) {
+        return wait && waitForQuota(duration);
+    });
+    if (!slot && wait)
+        throw StreamException("Cancelled while waiting for a stream of the shared quota.");
+    return static_cast<bool>(slot);
+}
+
+RecognitionSession::Attempt RecognitionSession::openAttempt(const std::shared_ptr<Endpoint> &endpoint,
+                                                            SharedQuota::Lease slot) {
+    // The deadline starts once the stream slot is taken, waiting for it is not part of the recognition.
+    Attempt attempt(*this, endpoint, std::move(slot));
+    client.prepareContext(*attempt.context);
+    if (timeout.count() > 0)
+        attempt.context->set_deadline(std::chrono::system_clock::now() + timeout);
+    attempt.stream = wire::openRecognitionStream(endpoint->channel, attempt.context.get());
+    INFO("Stream created on '{}'. State {}", endpoint->host, endpoint->channel->GetState(true));
+    return attempt;
+}
+
+std::size_t RecognitionSession::countRequests() const {
+    return 1 + (audio ? audio->chunks.size() : 0);
+}
+
+const wire::Frame &RecognitionSession::getRequest(std::size_t index) const {
+    return index == 0 ? config : audio->chunks[index - 1];
+}
+
+void RecognitionSession::record(const wire::Frame &request) {
+    // Captures are rare enough to afford parsing the wire buffer back, which leaves a copy to parse.
+    grpc::ByteBuffer copy(request.buffer);
+    Request message;
+    if (wire::parse(copy, message))
+        recorder->record(message);
+}
+
+bool RecognitionSession::sendHead(const Attempt &attempt) const {
+    TRACE_SCOPE("sendHead");
+    const auto length = std::min(headLength, countRequests());
+    for (std::size_t i = 0; i < length; ++i) {
+        // A buffer hint holds the write back until the last one of the head, which flushes them together.
+        grpc::WriteOptions options;
+        if (client.transport->coalesceHead && i + 1 < length)
+            options.set_buffer_hint();
+        if (!attempt.stream->Write(getRequest(i).buffer, options))
+            return false;
+    }
+    return true;
+}
+
+void RecognitionSession::startCapture() {
+    if (client.configuration.getCapturePath().empty())
+        return;
+    recorder = std::make_unique<SessionRecorder>(sessionPath(client.configuration.getCapturePath()));
+    for (std::size_t i = 0; i < std::min(headLength, countRequests()); ++i)
+        record(getRequest(i));
+}
+
+void RecognitionSession::streamOn(const std::shared_ptr<Endpoint> &endpoint) {
+    SharedQuota::Lease slot;
+    takeStreamSlot(slot, true);
+    auto attempt = openAttempt(endpoint, std::move(slot));
+    auto start = std::chrono::steady_clock::now();
+    if (!sendHead(attempt)) {
+        // Throws with the status that closed the stream, if any.
+        finish(attempt, 0);
+        throw StreamException("Stream on '" + endpoint->host + "' closed before the config was sent.");
+    }
+    startCapture();
+    finish(attempt, bidirectionalStream(attempt.stream, start));
+}
+
+void RecognitionSession::hedgedStream(const std::vector<std::shared_ptr<Endpoint>> &candidates) {
+    std::vector<Attempt> attempts;
+    for (const auto &candidate: candidates) {
+        // Only the first stream waits for the shared quota, a hedge is not worth holding up the session.
+        SharedQuota::Lease slot;
+        if (!takeStreamSlot(slot, attempts.empty())) {
+            INFO("No stream of the shared quota left to hedge on '{}'.", candidate->host);
+            break;
+        }
+        attempts.emplace_back(openAttempt(candidate, std::move(slot)));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<char> accepted(attempts.size());
+    {
+        std::vector<std::thread> senders;
+        for (std::size_t i = 0; i < attempts.size(); ++i)
+            senders.emplace_back([&, i] {
+                TraceSession::Scope traceScope(&trace);
+                accepted[i] = sendHead(attempts[i]);
+            });
+        for (auto &sender: senders)
+            sender.join();
+    }
+    std::vector<std::shared_ptr<Stream>> streams;
+    for (std::size_t i = 0; i < attempts.size(); ++i)
+        if (accepted[i])
+            streams.emplace_back(attempts[i].stream);
+
+    // Every stream that took the head gets the audio until one of them returns a response. That one goes on and
+    // the others are cancelled, so the session stays with the first server to answer.
+    int winner = -1;
+    int responses = 0;
+    if (!streams.empty()) {
+        startCapture();
+        std::packaged_task<void()> parallel_write([this, streams, start] {
+            TraceSession::Scope traceScope(&trace);
+            write(streams, start);
+        });
+        auto written = parallel_write.get_future();
+        auto writer = std::thread{std::move(parallel_write)};
+
+        std::mutex raceMutex;
+        std::condition_variable settled;
+        std::size_t unanswered = 0;
+        // Streams already closed by their server are not cancelled, which would replace their status.
+        std::vector<char> racing = accepted;
+        std::vector<grpc::ByteBuffer> firstResponses(attempts.size());
+        std::vector<std::thread> readers;
+        for (std::size_t i = 0; i < attempts.size(); ++i) {
+            if (!accepted[i])
+                continue;
+            readers.emplace_back([&, i] {
+                TraceSession::Scope traceScope(&trace);
+                bool answered = attempts[i].stream->Read(&firstResponses[i]);
+                std::lock_guard<std::mutex> lock(raceMutex);
+                if (answered && winner < 0) {
+                    winner = static_cast<int>(i);
+                    for (std::size_t j = 0; j < attempts.size(); ++j)
+                        if (j != i && racing[j])
+                            attempts[j].context->TryCancel();
+                } else if (!answered) {
+                    racing[i] = false;
+                    ++unanswered;
+                }
+                settled.notify_all();
+            });
+        }
+        {
+            std::unique_lock<std::mutex> lock(raceMutex);
+            settled.wait(lock, [&] { return winner >= 0 || unanswered == readers.size(); });
+        }
+        if (winner >= 0) {
+            INFO("Hedged session continues on '{}'.", attempts[winner].endpoint->host);
+            responses = readFromStream(attempts[winner].stream, start, &firstResponses[winner]);
+        }
+        for (auto &reader: readers)
+            reader.join();
+        writer.join();
+        if (isCancelled())
+            audio.reset();
+        written.get();
+    }
+
+    std::string failures;
+    std::size_t unavailable = 0;
+    grpc::Status closed(grpc::StatusCode::UNAVAILABLE, "");
+    for (std::size_t i = 0; i < attempts.size(); ++i) {
+        if (static_cast<int>(i) == winner)
+            continue;
+        auto status = attempts[i].stream->Finish();
+        attempts[i].slot.release();
+        DEBUG("Hedged stream on '{}' closed: {}", attempts[i].endpoint->host, status.error_message());
+        if (status.error_code() == grpc::StatusCode::UNAVAILABLE) {
+            client.endpointPool->reportUnavailable(attempts[i].endpoint);
+            failures += (failures.empty() ? "" : ", ") + attempts[i].endpoint->host;
+            ++unavailable;
+        } else if (closed.error_code() == grpc::StatusCode::UNAVAILABLE || status.ok()) {
+            closed = status;
+        }
+    }
+    if (winner >= 0) {
+        finish(attempts[winner], responses);
+        return;
+    }
+    if (unavailable == attempts.size())
+        throw EndpointUnavailable(failures, "no hedged stream answered");
+
+    // No stream answered and at least one was closed by its server, which decides the session as a single stream
+    // would.
+    statusCode = closed.error_code();
+    if (closed.ok()) {
+        INFO("Hedged streams closed without results.");
+        return;
+    }
+    ERROR("RESPONSE ERROR!\n\n");
+    ERROR("{} (GRPC_ERR_CODE {} - {})", closed.error_message(), closed.error_code(), closed.error_details());
+    throw StreamException(closed.error_message());
+}
+
+void RecognitionSession::finish(Attempt &attempt, int responses) {
+    grpc::Status status;
+    {
+        TRACE_SCOPE("stream->Finish");
+        status = attempt.stream->Finish();
+    }
+    attempt.slot.release();
+    statusCode = status.error_code();
+    if (status.ok()) {
+        client.endpointPool->reportAvailable(attempt.endpoint);
+        return;
+    }
+    ERROR("RESPONSE ERROR!\n\n");
+    ERROR("{} (GRPC_ERR_CODE {} - {})", status.error_message(), status.error_code(), status.error_details());
+    if (status.error_code() == grpc::StatusCode::UNAVAILABLE && responses == 0) {
+        client.endpointPool->reportUnavailable(attempt.endpoint);
+        throw EndpointUnavailable(attempt.endpoint->host, status.error_message());
+    }
+    throw StreamException(status.error_message());
+}
+
+int RecognitionSession::bidirectionalStream(std::shared_ptr<Stream> &stream,
+                                            std::chrono::steady_clock::time_point start) {
+    std::packaged_task<void(std::shared_ptr<Stream>)> parallel_write(
+            [this, start](std::shared_ptr<Stream> stream) {
+                TraceSession::Scope traceScope(&trace);
+                write({stream}, start);
+            });
+    auto result = parallel_write.get_future();
+    auto thread = std::thread{std::move(parallel_write), stream};
+
+    int responses = readFromStream(stream, start);
+
+    thread.join();
+    if (isCancelled())
+        audio.reset();
+    result.get();
+    return responses;
+}
+
+bool RecognitionSession::writeAll(std::vector<std::shared_ptr<Stream>> &streams, const grpc::ByteBuffer &request) {
+    // A stream whose write fails is dropped, e.g. a hedged one cancelled because the other answered first.
+    streams.erase(std::remove_if(streams.begin(), streams.end(),
+                                 [&request](const std::shared_ptr<Stream> &stream) { return !stream->Write(request); }),
+                  streams.end());
+    return !streams.empty();
+}
+
+void RecognitionSession::write(std::vector<std::shared_ptr<Stream>> streams,
+                               std::chrono::steady_clock::time_point start) {
+
+    INFO("Writing to stream...");
+    constexpr int bytesPerSamples = 2;// PCM16
+    const auto sampleRate = client.configuration.getSampleRate();
+    auto deadline = start;
+    int requestCount = 0;
+    for (std::size_t i = 0; i < countRequests(); ++i) {
+        const auto &request = getRequest(i);
+        if (i >= headLength) {
+            {
+                TRACE_SCOPE("pacing");
+                std::unique_lock<std::mutex> lock(mutex);
+                if (cancelled.wait_until(lock, deadline, [this] { return cancelRequested; }))
+                    return;
+            }
+            TRACE_SCOPE("stream->Write");
+            if (!writeAll(streams, request.buffer)) {
+                ERROR("Stream closed by the server after {} requests.", i);
+                return;
+            }
+            if (recorder)
+                record(request);
+            ++requestCount;
+            if (requestCount % 10 == 0)
+                INFO("Sent {} bytes of audio", requestCount * request.audioBytes);
+        }
+        deadline += std::chrono::microseconds(request.audioBytes * 1000000 / (bytesPerSamples * sampleRate));
+        audioSent = std::chrono::duration_cast<std::chrono::microseconds>(deadline - start);
+    }
+    if (live && !writeLive(streams))
+        return;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (cancelled.wait_until(lock, deadline, [this] { return cancelRequested; }))
+            return;
+    }
+    for (const auto &stream: streams)
+        stream->WritesDone();
+    INFO("All audio sent in {} requests.", countRequests());
+}
+
+bool RecognitionSession::writeLive(std::vector<std::shared_ptr<Stream>> &streams) {
+    constexpr int bytesPerSamples = 2;// PCM16
+    std::string chunk;
+    int requestCount = 0;
+    while (live->pop(chunk)) {
+        if (isCancelled())
+            return false;
+        // Live audio cannot wait for the quota, it is only accounted for so that the other processes leave room.
+        if (client.quota)
+            client.quota->consumeAudio(std::chrono::microseconds(
+                    chunk.size() * 1000000 / (bytesPerSamples * live->getSampleRate())));
+        auto request = wire::audioFrame(std::move(chunk));
+        TRACE_SCOPE("stream->Write");
+        if (!writeAll(streams, request.buffer)) {
+            ERROR("Stream closed by the server after {} live requests.", requestCount);
+            return false;
+        }
+        if (recorder)
+            record(request);
+        ++requestCount;
+    }
+    INFO("Live audio ended after {} requests.", requestCount);
+    return !isCancelled();
+}
+
+void RecognitionSession::trackLatency(const RecognitionResult &result, std::chrono::steady_clock::time_point start) {
+    if (!result.is_final() || result.alternatives().empty() || result.alternatives(0).words().empty())
+        return;
+    const auto &words = result.alternatives(0).words();
+    // The audio is sent in real time from start, so the end of the last word was sent at start + end_time.
+    auto sent = start + std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::duration<float>(words[words.size() - 1].end_time()));
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - sent);
+    finalLatency = std::max(finalLatency, latency);
+}
+
+int RecognitionSession::readFromStream(std::shared_ptr<Stream> &stream, std::chrono::steady_clock::time_point start,
+                                       grpc::ByteBuffer *firstResponse) {
+
+    INFO("Reading from stream...");
+    int responses = 0;
+    ResponseArena arena;
+    grpc::ByteBuffer buffer;
+    if (firstResponse)
+        buffer.Swap(firstResponse);
+    auto read = [&] {
+        if (firstResponse) {
+            firstResponse = nullptr;
+            return true;
+        }
+        TRACE_SCOPE("stream->Read");
+        return stream->Read(&buffer);
+    };
+    while (read()) {
+        Response *response = arena.next();
+        if (!wire::parse(buffer, *response)) {
+            ERROR("Skipped a response that could not be parsed.");
+            continue;
+        }
+        ++responses;
+        if (recorder)
+            recorder->record(*response);
+        trackLatency(response->result(), start);
+        if (printResults)
+            RecognitionClient::printResult(response->result());
+        if (listener)
+            listener(response->result());
+    }
+    return responses;
+}
@@ -0,0 +1,18 @@
+#include "ResponseArena.h"
+
+using namespace speechcenter::recognizer::v1;
+
+ResponseArena::ResponseArena(std::size_t initialBlockSize) : initialBlock(new char[initialBlockSize]),
+                                                             arena(buildOptions(initialBlock.get(), initialBlockSize)) {}
+
+RecognitionStreamingResponse *ResponseArena::next() {
+    arena.Reset();
+    return google::protobuf::Arena::CreateMessage<RecognitionStreamingResponse>(&arena);
+}
+
+google::protobuf::ArenaOptions ResponseArena::buildOptions(char *block, std::size_t size) {
+    google::protobuf::ArenaOptions options;
+    options.initial_block = block;
+    options.initial_block_size = size;
+    return options;
+}
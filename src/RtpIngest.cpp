@@ -0,0 +1,222 @@
+#include "RtpIngest.h"
+
+#include "G711.h"
+#include "gRpcExceptions.h"
+#include "logger.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+    constexpr uint32_t stopEvent = UINT32_MAX;
+    constexpr int receiveBufferSize = 4 * 1024 * 1024;
+
+    std::string describeError(const std::string &what) {
+        return what + ": " + std::strerror(errno);
+    }
+
+    int bindUdp(uint16_t port) {
+        int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+            throw IOError(describeError("Unable to create UDP socket"));
+        int enable = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+        // Many flows share a socket, so give bursts room before the kernel starts dropping datagrams.
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receiveBufferSize, sizeof(receiveBufferSize));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(port);
+        if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+            auto message = describeError("Unable to bind UDP port " + std::to_string(port));
+            close(fd);
+            throw IOError(message);
+        }
+        return fd;
+    }
+
+    uint16_t boundPort(int fd) {
+        sockaddr_in address{};
+        socklen_t length = sizeof(address);
+        getsockname(fd, reinterpret_cast<sockaddr *>(&address), &length);
+        return ntohs(address.sin_port);
+    }
+
+}
+
+bool RtpIngest::FlowKey::operator==(const FlowKey &other) const {
+    return address == other.address && port == other.port && localPort == other.localPort && ssrc == other.ssrc;
+}
+
+std::size_t RtpIngest::FlowKeyHash::operator()(const FlowKey &key) const {
+    uint64_t value = (static_cast<uint64_t>(key.address) << 32 | key.ssrc) ^
+                     (static_cast<uint64_t>(key.port) << 16 | key.localPort) * 0x9E3779B97F4A7C15ULL;
+    return std::hash<uint64_t>{}(value);
+}
+
+RtpIngest::RtpIngest(const std::vector<uint16_t> &ports, std::chrono::milliseconds jitterDelay,
+                     std::chrono::milliseconds idleTimeout, FlowHandler onFlow) :
+        jitterDelay(jitterDelay), idleTimeout(idleTimeout), onFlow(std::move(onFlow)) {
+    try {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epollFd < 0 || stopFd < 0)
+            throw IOError(describeError("Unable to create the RTP event loop"));
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u32 = stopEvent;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, stopFd, &event);
+        for (auto port: ports) {
+            sockets.emplace_back(bindUdp(port));
+            this->ports.emplace_back(boundPort(sockets.back()));
+            event.data.u32 = static_cast<uint32_t>(sockets.size() - 1);
+            if (epoll_ctl(epollFd, EPOLL_CTL_ADD, sockets.back(), &event) < 0)
+                throw IOError(describeError("Unable to watch UDP port " + std::to_string(port)));
+        }
+    } catch (...) {
+        for (auto fd: sockets)
+            close(fd);
+        if (stopFd >= 0)
+            close(stopFd);
+        if (epollFd >= 0)
+            close(epollFd);
+        throw;
+    }
+    INFO("Listening for RTP on {} UDP ports.", this->ports.size());
+}
+
+RtpIngest::~RtpIngest() {
+    for (auto flow = flows.begin(); flow != flows.end();)
+        flow = endFlow(flow);
+    for (auto fd: sockets)
+        close(fd);
+    close(stopFd);
+    close(epollFd);
+}
+
+std::vector<uint16_t> RtpIngest::getPorts() const {
+    return ports;
+}
+
+void RtpIngest::stop() {
+    uint64_t one = 1;
+    // write() is async-signal-safe; the result does not matter as any pending count already stops the loop.
+    [[maybe_unused]] auto written = write(stopFd, &one, sizeof(one));
+}
+
+void RtpIngest::run() {
+    std::array<epoll_event, 16> events{};
+    auto wakeUp = Clock::time_point::max();
+    while (true) {
+        int timeout = -1;
+        if (wakeUp != Clock::time_point::max()) {
+            auto remaining = std::chrono::ceil<std::chrono::milliseconds>(wakeUp - Clock::now()).count();
+            timeout = static_cast<int>(std::clamp<int64_t>(remaining, 0, 1000));
+        }
+        int ready = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), timeout);
+        if (ready < 0 && errno != EINTR)
+            throw IOError(describeError("RTP event loop failed"));
+        for (int i = 0; i < ready; ++i) {
+            if (events[i].data.u32 == stopEvent) {
+                for (auto flow = flows.begin(); flow != flows.end();)
+                    flow = endFlow(flow);
+                return;
+            }
+            receive(sockets[events[i].data.u32], ports[events[i].data.u32]);
+        }
+        wakeUp = service(Clock::now());
+    }
+}
+
+void RtpIngest::receive(int socket, uint16_t localPort) {
+    std::array<std::array<uint8_t, maxDatagramSize>, batchSize> buffers;
+    std::array<sockaddr_in, batchSize> sources{};
+    std::array<iovec, batchSize> vectors{};
+    std::array<mmsghdr, batchSize> messages{};
+    for (std::size_t i = 0; i < batchSize; ++i) {
+        vectors[i] = {buffers[i].data(), buffers[i].size()};
+        messages[i].msg_hdr.msg_iov = &vectors[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+        messages[i].msg_hdr.msg_name = &sources[i];
+    }
+    while (true) {
+        for (auto &message: messages)
+            message.msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        // One system call drains a whole batch of datagrams.
+        int received = recvmmsg(socket, messages.data(), batchSize, MSG_DONTWAIT, nullptr);
+        if (received <= 0)
+            return;
+        const auto now = Clock::now();
+        for (int i = 0; i < received; ++i) {
+            RtpPacket packet;
+            if (!RtpPacket::parse(buffers[i].data(), messages[i].msg_len, packet))
+                continue;
+            if (packet.payloadType != RtpPacket::payloadTypePcmu && packet.payloadType != RtpPacket::payloadTypePcma) {
+                DEBUG("Ignoring RTP payload type {} on port {}", packet.payloadType, localPort);
+                continue;
+            }
+            handle({sources[i].sin_addr.s_addr, sources[i].sin_port, localPort, packet.ssrc}, packet, now);
+        }
+        if (received < static_cast<int>(batchSize))
+            return;
+    }
+}
+
+void RtpIngest::handle(const FlowKey &key, const RtpPacket &packet, Clock::time_point now) {
+    auto flow = flows.find(key);
+    if (flow == flows.end()) {
+        char address[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &key.address, address, sizeof(address));
+        auto name = std::string(address) + ":" + std::to_string(ntohs(key.port)) + "/" + std::to_string(key.ssrc);
+        auto audio = std::make_shared<LiveAudio>(g711::sampleRate, chunkDuration);
+        flow = flows.emplace(key, Flow{name, JitterBuffer(jitterDelay), audio, now}).first;
+        INFO("New RTP flow {} on port {} ({})", name, key.localPort,
+             packet.payloadType == RtpPacket::payloadTypePcmu ? "PCMU" : "PCMA");
+        onFlow(name, audio);
+    }
+
+    std::vector<int16_t> decoded(packet.payloadSize);
+    if (packet.payloadType == RtpPacket::payloadTypePcmu)
+        g711::decodeUlaw(packet.payload, decoded.data(), decoded.size());
+    else
+        g711::decodeAlaw(packet.payload, decoded.data(), decoded.size());
+    flow->second.jitter.push(packet.sequence, std::move(decoded), now);
+    flow->second.lastArrival = now;
+}
+
+RtpIngest::Clock::time_point RtpIngest::service(Clock::time_point now) {
+    auto wakeUp = Clock::time_point::max();
+    for (auto flow = flows.begin(); flow != flows.end();) {
+        if (now - flow->second.lastArrival >= idleTimeout) {
+            flow = endFlow(flow);
+            continue;
+        }
+        samples.clear();
+        flow->second.jitter.pop(now, samples);
+        flow->second.audio->push(samples.data(), samples.size());
+        wakeUp = std::min({wakeUp, flow->second.jitter.nextRelease(), flow->second.lastArrival + idleTimeout});
+        ++flow;
+    }
+    return wakeUp;
+}
+
+RtpIngest::Flows::iterator RtpIngest::endFlow(Flows::iterator flow) {
+    samples.clear();
+    flow->second.jitter.flush(samples);
+    flow->second.audio->push(samples.data(), samples.size());
+    flow->second.audio->close();
+    const auto &statistics = flow->second.jitter.getStatistics();
+    INFO("RTP flow {} ended: {} packets, {} reordered, {} duplicated, {} late, {} concealed.", flow->second.name,
+         statistics.received, statistics.reordered, statistics.duplicates, statistics.late, statistics.concealed);
+    return flows.erase(flow);
+}
@@ -0,0 +1,59 @@
+#include "RtpPacket.h"
+
+namespace {
+
+    constexpr std::size_t fixedHeaderSize = 12;
+
+    uint16_t readUint16(const uint8_t *data) {
+        return static_cast<uint16_t>(data[0] << 8 | data[1]);
+    }
+
+    uint32_t readUint32(const uint8_t *data) {
+        return static_cast<uint32_t>(data[0]) << 24 | static_cast<uint32_t>(data[1]) << 16 |
+               static_cast<uint32_t>(data[2]) << 8 | data[3];
+    }
+
+    void writeUint32(std::vector<uint8_t> &data, uint32_t value) {
+        for (int shift = 24; shift >= 0; shift -= 8)
+            data.emplace_back(static_cast<uint8_t>(value >> shift));
+    }
+
+}
+
+bool RtpPacket::parse(const uint8_t *data, std::size_t size, RtpPacket &packet) {
+    if (size < fixedHeaderSize || (data[0] >> 6) != 2)
+        return false;
+    const bool padding = data[0] & 0x20;
+    const bool extension = data[0] & 0x10;
+    std::size_t headerSize = fixedHeaderSize + 4 * (data[0] & 0x0F);
+    if (extension) {
+        if (size < headerSize + 4)
+            return false;
+        headerSize += 4 + 4 * static_cast<std::size_t>(readUint16(data + headerSize + 2));
+    }
+    std::size_t paddingSize = padding ? data[size - 1] : 0;
+    if (size < headerSize + paddingSize)
+        return false;
+
+    packet.marker = data[1] & 0x80;
+    packet.payloadType = data[1] & 0x7F;
+    packet.sequence = readUint16(data + 2);
+    packet.timestamp = readUint32(data + 4);
+    packet.ssrc = readUint32(data + 8);
+    packet.payload = data + headerSize;
+    packet.payloadSize = size - headerSize - paddingSize;
+    return true;
+}
+
+std::vector<uint8_t> RtpPacket::serialize() const {
+    std::vector<uint8_t> data;
+    data.reserve(fixedHeaderSize + payloadSize);
+    data.emplace_back(0x80);
+    data.emplace_back(static_cast<uint8_t>((marker ? 0x80 : 0) | (payloadType & 0x7F)));
+    data.emplace_back(static_cast<uint8_t>(sequence >> 8));
+    data.emplace_back(static_cast<uint8_t>(sequence));
+    writeUint32(data, timestamp);
+    writeUint32(data, ssrc);
+    data.insert(data.end(), payload, payload + payloadSize);
+    return data;
+}
@@ -0,0 +1,67 @@
+#include "SessionCapture.h"
+
+#include "gRpcExceptions.h"
+#include "logger.h"
+
+#include <algorithm>
+
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/util/delimited_message_util.h>
+
+using namespace speechcenter::recognizer::v1;
+
+SessionRecorder::SessionRecorder(const std::string &capturePath) : output(capturePath, std::ios::binary | std::ios::trunc),
+                                                                   capturePath(capturePath),
+                                                                   start(std::chrono::steady_clock::now()) {
+    if (!output)
+        throw IOError("Unable to open capture file '" + capturePath + "'");
+    INFO("Capturing session to '{}'", capturePath);
+}
+
+SessionRecorder::~SessionRecorder() = default;
+
+void SessionRecorder::record(const RecognitionStreamingRequest &request) {
+    CaptureRecord record;
+    *record.mutable_request() = request;
+    append(record);
+}
+
+void SessionRecorder::record(const RecognitionStreamingResponse &response) {
+    CaptureRecord record;
+    *record.mutable_response() = response;
+    append(record);
+}
+
+void SessionRecorder::append(CaptureRecord &record) {
+    std::lock_guard<std::mutex> lock(mutex);
+    record.set_timestamp_us(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    if (!google::protobuf::util::SerializeDelimitedToOstream(record, &output))
+        throw IOError("Unable to write to capture file '" + capturePath + "'");
+    output.flush();
+}
+
+SessionCapture::SessionCapture(const std::string &capturePath) {
+    std::ifstream input(capturePath, std::ios::binary);
+    if (!input)
+        throw IOError("Unable to open capture file '" + capturePath + "'");
+    google::protobuf::io::IstreamInputStream stream(&input);
+    bool cleanEof = false;
+    CaptureRecord record;
+    while (google::protobuf::util::ParseDelimitedFromZeroCopyStream(&record, &stream, &cleanEof))
+        records.emplace_back(std::move(record));
+    if (!cleanEof)
+        WARN("Capture file '{}' is truncated, read {} records.", capturePath, records.size());
+}
+
+std::chrono::microseconds SessionCapture::getDuration() const {
+    return std::chrono::microseconds(records.empty() ? 0 : records.back().timestamp_us());
+}
+
+std::size_t SessionCapture::countRequests() const {
+    return std::count_if(records.begin(), records.end(), [](const auto &record) { return record.has_request(); });
+}
+
+std::size_t SessionCapture::countResponses() const {
+    return std::count_if(records.begin(), records.end(), [](const auto &record) { return record.has_response(); });
+}
@@ -0,0 +1,244 @@
+#include "SharedQuota.h"
+
+#include "gRpcExceptions.h"
+#include "logger.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+    constexpr std::uint32_t segmentVersion = 1;
+
+    // Start time of the process in clock ticks since boot, zero if unknown. Tells a reused pid from its first owner.
+    std::uint64_t processStartTime(pid_t pid) {
+        std::ifstream input("/proc/" + std::to_string(pid) + "/stat");
+        std::string stat;
+        if (!std::getline(input, stat))
+            return 0;
+        // The command name may contain spaces, the fields after it do not. The start time is the 20th after it.
+        const auto commandEnd = stat.rfind(')');
+        if (commandEnd == std::string::npos)
+            return 0;
+        std::istringstream fields(stat.substr(commandEnd + 1));
+        std::string field;
+        for (int i = 0; i < 20; ++i)
+            if (!(fields >> field))
+                return 0;
+        return std::strtoull(field.c_str(), nullptr, 10);
+    }
+
+    std::uint64_t makeOwner(pid_t pid) {
+        return (processStartTime(pid) & 0xffffffffu) << 32 | static_cast<std::uint32_t>(pid);
+    }
+
+    bool isStale(std::uint64_t owner) {
+        const auto pid = static_cast<pid_t>(owner & 0xffffffffu);
+        if (kill(pid, 0) == -1 && errno == ESRCH)
+            return true;
+        const auto startTime = owner >> 32;
+        const auto current = processStartTime(pid) & 0xffffffffu;
+        return startTime != 0 && current != 0 && current != startTime;
+    }
+
+    std::int64_t monotonicNow() {
+        // steady_clock is CLOCK_MONOTONIC, which every process of the host shares.
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+}
+
+struct SharedQuota::Segment {
+    std::atomic<std::uint32_t> ready;
+    std::uint32_t version;
+    std::uint64_t streams;
+    double audioRate;
+    // Time at which the audio taken so far is paid off at the rate, in monotonic nanoseconds.
+    std::atomic<std::int64_t> schedule;
+    std::atomic<std::uint64_t> slots[maxStreams];// owner of each stream slot, zero when free
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<std::int64_t>::is_always_lock_free,
+              "The shared quota needs lock-free 64 bit atomics.");
+
+SharedQuota::Lease::Lease(SharedQuota *quota, std::size_t slot) : quota(quota), slot(slot) {}
+
+SharedQuota::Lease::Lease(Lease &&other) noexcept: quota(other.quota), slot(other.slot) {
+    other.quota = nullptr;
+}
+
+SharedQuota::Lease &SharedQuota::Lease::operator=(Lease &&other) noexcept {
+    if (this != &other) {
+        release();
+        quota = other.quota;
+        slot = other.slot;
+        other.quota = nullptr;
+    }
+    return *this;
+}
+
+SharedQuota::Lease::~Lease() {
+    release();
+}
+
+SharedQuota::Lease::operator bool() const {
+    return quota != nullptr;
+}
+
+void SharedQuota::Lease::release() {
+    if (!quota)
+        return;
+    if (slot < maxStreams) {
+        // Leaves the slot alone if it was reclaimed from under us.
+        auto expected = quota->owner;
+        quota->segment->slots[slot].compare_exchange_strong(expected, 0);
+    }
+    quota = nullptr;
+}
+
+SharedQuota::SharedQuota(const std::string &objectName, const Limits &requested) :
+        name(objectName.empty() || objectName[0] != '/' ? "/" + objectName : objectName), limits(requested),
+        owner(makeOwner(getpid())) {
+    if (limits.streams > maxStreams)
+        throw IOError("The shared quota allows at most " + std::to_string(maxStreams) + " streams");
+    bool creator = true;
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 && errno == EEXIST) {
+        creator = false;
+        fd = shm_open(name.c_str(), O_RDWR, 0600);
+    }
+    if (fd < 0)
+        throw IOError("Unable to open shared quota '" + name + "': " + std::strerror(errno));
+    if (creator && ftruncate(fd, sizeof(Segment)) != 0) {
+        close(fd);
+        throw IOError("Unable to size shared quota '" + name + "': " + std::strerror(errno));
+    }
+    // A joining process may get here before the creator has sized the object.
+    struct stat status{};
+    for (int i = 0; fstat(fd, &status) == 0 && status.st_size < static_cast<off_t>(sizeof(Segment)); ++i) {
+        if (i == 100) {
+            close(fd);
+            throw IOError("Shared quota '" + name + "' has an unexpected size, remove it from /dev/shm");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    void *memory = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED)
+        throw IOError("Unable to map shared quota '" + name + "': " + std::strerror(errno));
+    // The object is zero-filled, which is the initial state of every atomic.
+    segment = static_cast<Segment *>(memory);
+
+    if (creator) {
+        segment->version = segmentVersion;
+        segment->streams = limits.streams;
+        segment->audioRate = limits.audioRate;
+        segment->ready.store(1, std::memory_order_release);
+        INFO("Created shared quota '{}': {} streams, {} audio seconds per second.", name, limits.streams,
+             limits.audioRate);
+        return;
+    }
+    for (int i = 0; segment->ready.load(std::memory_order_acquire) == 0; ++i) {
+        if (i == 100) {
+            munmap(segment, sizeof(Segment));
+            throw IOError("Shared quota '" + name + "' was never initialized, remove it from /dev/shm");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (segment->version != segmentVersion) {
+        munmap(segment, sizeof(Segment));
+        throw IOError("Shared quota '" + name + "' has an incompatible layout, remove it from /dev/shm");
+    }
+    if (segment->streams != limits.streams || segment->audioRate != limits.audioRate)
+        WARN("Shared quota '{}' already exists with {} streams and {} audio seconds per second, using those.", name,
+             segment->streams, segment->audioRate);
+    limits = {static_cast<std::size_t>(segment->streams), segment->audioRate};
+    INFO("Joined shared quota '{}', {} stale stream slots reclaimed.", name, reclaimStale());
+}
+
+SharedQuota::~SharedQuota() {
+    // The object itself stays for the other processes of the host.
+    munmap(segment, sizeof(Segment));
+}
+
+SharedQuota::Lease SharedQuota::acquireStream(const Waiter &wait) {
+    if (limits.streams == 0)
+        return {this, maxStreams};
+    auto backoff = std::chrono::milliseconds(5);
+    for (;;) {
+        for (std::size_t i = 0; i < limits.streams; ++i) {
+            std::uint64_t expected = 0;
+            if (segment->slots[i].compare_exchange_strong(expected, owner))
+                return {this, i};
+        }
+        if (reclaimStale() > 0)
+            continue;
+        if (!wait(backoff))
+            return {};
+        backoff = std::min(backoff * 2, std::chrono::milliseconds(200));
+    }
+}
+
+std::int64_t SharedQuota::reserve(std::chrono::microseconds audio, bool wait) {
+    const auto cost = static_cast<std::int64_t>(static_cast<double>(audio.count()) * 1000 / limits.audioRate);
+    const std::int64_t burstNs = std::chrono::duration_cast<std::chrono::nanoseconds>(burst).count();
+    auto schedule = segment->schedule.load();
+    for (;;) {
+        const auto now = monotonicNow();
+        // An idle bucket does not save tokens up beyond the burst.
+        const auto base = std::max(schedule, now);
+        // Audio longer than the burst is let through on an empty bucket and paid off afterwards.
+        if (wait && base - now > burstNs)
+            return base - now - burstNs;
+        if (segment->schedule.compare_exchange_weak(schedule, base + cost))
+            return 0;
+    }
+}
+
+bool SharedQuota::acquireAudio(std::chrono::microseconds audio, const Waiter &wait) {
+    if (limits.audioRate <= 0)
+        return true;
+    for (;;) {
+        const auto pending = reserve(audio, true);
+        if (pending == 0)
+            return true;
+        const auto sleep = std::min<std::int64_t>(pending / 1000000 + 1, 1000);
+        if (!wait(std::chrono::milliseconds(sleep)))
+            return false;
+    }
+}
+
+void SharedQuota::consumeAudio(std::chrono::microseconds audio) {
+    if (limits.audioRate > 0)
+        reserve(audio, false);
+}
+
+std::size_t SharedQuota::reclaimStale() {
+    std::size_t reclaimed = 0;
+    for (std::size_t i = 0; i < limits.streams; ++i) {
+        auto holder = segment->slots[i].load();
+        if (holder == 0 || holder == owner || !isStale(holder))
+            continue;
+        if (segment->slots[i].compare_exchange_strong(holder, 0)) {
+            WARN("Reclaimed stream slot {} of process {}, which is gone.", i, holder & 0xffffffffu);
+            ++reclaimed;
+        }
+    }
+    return reclaimed;
+}
+
+const SharedQuota::Limits &SharedQuota::getLimits() const {
+    return limits;
+}
@@ -0,0 +1,150 @@
+#include "SpeculativeRecognition.h"
+
+#include "gRpcExceptions.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <thread>
+
+SpeculativeRecognition::SpeculativeRecognition(RecognitionClient &client, std::vector<Candidate> candidates,
+                                               std::chrono::milliseconds warmUp) : client(client), warmUp(warmUp) {
+    for (auto &candidate: candidates)
+        contenders.emplace_back().candidate = std::move(candidate);
+}
+
+SpeculativeRecognition::~SpeculativeRecognition() {
+    for (auto &contender: contenders) {
+        if (!contender.running.valid())
+            continue;
+        contender.session->cancel();
+        contender.running.wait();
+    }
+}
+
+void SpeculativeRecognition::run(const Audio &audio, const ResultListener &resultListener) {
+    run(client.prepareAudio(audio), resultListener);
+}
+
+void SpeculativeRecognition::run(std::shared_ptr<const AudioRequests> requests, const ResultListener &resultListener) {
+    listener = resultListener;
+    // The kept candidate streams the whole audio, the others only until the choice. They are charged for what they
+    // actually sent once they are cancelled.
+    if (client.quota && !client.quota->acquireAudio(requests->duration, [](std::chrono::milliseconds duration) {
+        std::this_thread::sleep_for(duration);
+        return true;
+    }))
+        throw StreamException("Unable to take the shared audio quota.");
+    for (std::size_t i = 0; i < contenders.size(); ++i) {
+        SessionOptions options{contenders[i].candidate.language, contenders[i].candidate.topic, false, false};
+        contenders[i].session = client.createSession(
+                requests, [this, i](const RecognitionResult &result) { onResult(i, result); }, options);
+    }
+    requests.reset();
+    for (auto &contender: contenders)
+        contender.running = std::async(std::launch::async, [this, &contender] {
+            std::exception_ptr error;
+            try {
+                contender.session->run();
+            } catch (...) {
+                error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            contender.error = error;
+            contender.finished = true;
+            changed.notify_all();
+        });
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait_for(lock, warmUp, [this] { return allFinished(); });
+        // Past the warm-up, wait for a first score unless every candidate is done already.
+        changed.wait(lock, [this] { return allFinished() || anyScored(); });
+        winner = static_cast<int>(choose());
+        for (const auto &contender: contenders)
+            INFO("Candidate {}: confidence {:.3f}{}", describe(contender.candidate), contender.score(),
+                 contender.error ? " (failed)" : "");
+        INFO("Speculative recognition keeps {}", describe(contenders[winner].candidate));
+        for (const auto &result: contenders[winner].held) {
+            RecognitionClient::printResult(result);
+            if (listener)
+                listener(result);
+        }
+        contenders[winner].held.clear();
+    }
+    for (std::size_t i = 0; i < contenders.size(); ++i)
+        if (static_cast<int>(i) != winner)
+            contenders[i].session->cancel();
+    for (auto &contender: contenders)
+        contender.running.get();
+    if (client.quota)
+        for (std::size_t i = 0; i < contenders.size(); ++i)
+            if (static_cast<int>(i) != winner)
+                client.quota->consumeAudio(contenders[i].session->getAudioSent());
+    if (contenders[winner].error)
+        std::rethrow_exception(contenders[winner].error);
+}
+
+const SpeculativeRecognition::Candidate &SpeculativeRecognition::getWinner() const {
+    return contenders.at(winner).candidate;
+}
+
+const RecognitionSession *SpeculativeRecognition::getSession() const {
+    return winner < 0 ? nullptr : contenders[winner].session.get();
+}
+
+void SpeculativeRecognition::onResult(std::size_t index, const RecognitionResult &result) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &contender = contenders[index];
+    if (winner < 0) {
+        if (!result.alternatives().empty()) {
+            const auto &best = result.alternatives(0);
+            if (result.is_final()) {
+                const double weight = std::max(1, best.words_size());
+                contender.confidenceSum += best.confidence() * weight;
+                contender.confidenceWeight += weight;
+            } else {
+                contender.interimConfidence = best.confidence();
+            }
+        }
+        if (result.is_final())
+            contender.held.emplace_back(result);
+        changed.notify_all();
+        return;
+    }
+    if (static_cast<int>(index) != winner)
+        return;
+    RecognitionClient::printResult(result);
+    if (listener)
+        listener(result);
+}
+
+double SpeculativeRecognition::Contender::score() const {
+    return confidenceWeight > 0 ? confidenceSum / confidenceWeight : interimConfidence;
+}
+
+bool SpeculativeRecognition::allFinished() const {
+    return std::all_of(contenders.begin(), contenders.end(), [](const auto &contender) { return contender.finished; });
+}
+
+bool SpeculativeRecognition::anyScored() const {
+    return std::any_of(contenders.begin(), contenders.end(),
+                       [](const auto &contender) { return contender.score() >= 0; });
+}
+
+std::size_t SpeculativeRecognition::choose() const {
+    std::size_t best = 0;
+    for (std::size_t i = 1; i < contenders.size(); ++i) {
+        // A failed candidate only wins if every candidate failed.
+        const bool failed = contenders[i].error != nullptr, bestFailed = contenders[best].error != nullptr;
+        if (failed != bestFailed ? bestFailed : contenders[i].score() > contenders[best].score())
+            best = i;
+    }
+    return best;
+}
+
+std::string SpeculativeRecognition::describe(const Candidate &candidate) {
+    std::string description = candidate.language.empty() ? "configured language" : candidate.language;
+    if (!candidate.topic.empty())
+        description += "/" + candidate.topic;
+    return description;
+}
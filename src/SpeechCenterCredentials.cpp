@@ -11,6 +11,7 @@
 #include "jwt-cpp/jwt.h"
 #include "jwt-cpp/traits/nlohmann-json/traits.h"
 #include "gRpcExceptions.h"
+#include "Tracing.h"
 #include <chrono>
 #include "nlohmann/json.hpp"
 
@@ -21,6 +22,7 @@ SpeechCenterCredentials::SpeechCenterCredentials(const std::string& tokenFilePat
 }
 
 std::string SpeechCenterCredentials::getToken() {
+    TRACE_SCOPE("SpeechCenterCredentials::getToken");
     token = readFileContent(tokenFilePath);
     auto validUntil = decodeJwtExpirationTime();
     auto now = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
@@ -39,6 +41,7 @@ std::string SpeechCenterCredentials::getToken() {
 }
 
 std::string SpeechCenterCredentials::requestNewToken() const {
+    TRACE_SCOPE("SpeechCenterCredentials::requestNewToken");
 
     std::string json{
             R"({"client_id":")"
@@ -0,0 +1,86 @@
+#include "StandInServer.h"
+
+#include "gRpcExceptions.h"
+#include "logger.h"
+
+#include <grpcpp/security/server_credentials.h>
+#include <grpcpp/server_builder.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace speechcenter::recognizer::v1;
+
+StandInServer::StandInServer(const SessionCapture &capture, double timeScale) : capture(capture), timeScale(timeScale) {
+    std::size_t requests = 0;
+    for (const auto &record: capture.getRecords()) {
+        if (record.has_request())
+            ++requests;
+        else if (record.has_response())
+            schedule.push_back({std::chrono::microseconds(record.timestamp_us()), requests, &record.response()});
+    }
+}
+
+StandInServer::~StandInServer() {
+    shutdown();
+}
+
+int StandInServer::start(const std::string &address) {
+    int port = 0;
+    grpc::ServerBuilder builder;
+    builder.AddListeningPort(address, grpc::InsecureServerCredentials(), &port);
+    builder.RegisterService(this);
+    server = builder.BuildAndStart();
+    if (!server || port == 0)
+        throw IOError("Unable to start stand-in server on '" + address + "'");
+    INFO("Stand-in server listening on port {} with {} scheduled responses.", port, schedule.size());
+    return port;
+}
+
+void StandInServer::wait() {
+    if (server)
+        server->Wait();
+}
+
+void StandInServer::shutdown() {
+    if (server)
+        server->Shutdown();
+}
+
+grpc::Status StandInServer::StreamingRecognize(grpc::ServerContext *context,
+                                               grpc::ServerReaderWriter<RecognitionStreamingResponse,
+                                                       RecognitionStreamingRequest> *stream) {
+    const auto start = std::chrono::steady_clock::now();
+    std::mutex mutex;
+    std::condition_variable arrived;
+    std::size_t received = 0;
+    bool closed = false;
+
+    std::thread reader([&] {
+        RecognitionStreamingRequest request;
+        while (stream->Read(&request)) {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++received;
+            arrived.notify_all();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        arrived.notify_all();
+    });
+
+    for (const auto &scheduled: schedule) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            arrived.wait(lock, [&] { return closed || received >= scheduled.requestsBefore; });
+            if (received < scheduled.requestsBefore || context->IsCancelled())
+                break;
+        }
+        std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::microseconds>(
+                scheduled.offset * timeScale));
+        if (!stream->Write(*scheduled.response))
+            break;
+    }
+    reader.join();
+    return grpc::Status::OK;
+}
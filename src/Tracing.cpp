@@ -0,0 +1,71 @@
+#include "Tracing.h"
+
+#ifdef SPEECH_CENTER_TRACING
+
+#include "gRpcExceptions.h"
+#include "logger.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <unistd.h>
+
+namespace {
+
+    thread_local TraceSession *boundSession = nullptr;
+
+    const auto epoch = std::chrono::steady_clock::now();
+
+}
+
+TraceSession::Scope::Scope(TraceSession *session) : previous(boundSession) {
+    boundSession = session;
+}
+
+TraceSession::Scope::~Scope() {
+    boundSession = previous;
+}
+
+void TraceSession::add(const TraceEvent &event) {
+    std::lock_guard<std::mutex> lock(mutex);
+    events.emplace_back(event);
+}
+
+void TraceSession::merge(TraceSession &other) {
+    std::scoped_lock lock(mutex, other.mutex);
+    events.insert(events.end(), other.events.begin(), other.events.end());
+    other.events.clear();
+}
+
+void TraceSession::write(const std::string &path) const {
+    std::ofstream output(path);
+    if (!output)
+        throw IOError("Unable to open trace file '" + path + "'");
+    const auto pid = getpid();
+    std::lock_guard<std::mutex> lock(mutex);
+    output << "{\"traceEvents\":[";
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        const auto &event = events[i];
+        output << (i == 0 ? "\n" : ",\n")
+               << R"({"name":")" << event.name << R"(","ph":"X","ts":)" << event.startUs
+               << ",\"dur\":" << event.durationUs << ",\"pid\":" << pid << ",\"tid\":" << event.threadId << "}";
+    }
+    output << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    INFO("Wrote {} trace events to '{}'", events.size(), path);
+}
+
+TraceSession *TraceSession::current() {
+    return boundSession;
+}
+
+int64_t TraceSession::now() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+uint32_t TraceSession::threadId() {
+    static std::atomic<uint32_t> nextId{1};
+    thread_local const uint32_t id = nextId++;
+    return id;
+}
+
+#endif
@@ -0,0 +1,293 @@
+#include "TranscriptCache.h"
+
+#include "Audio.h"
+#include "Configuration.h"
+#include "gRpcExceptions.h"
+#include "logger.h"
+#include "transcript_cache.pb.h"
+
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace speechcenter::recognizer::v1;
+
+namespace {
+
+    constexpr uint64_t indexMagic = 0x3158444954435354ULL;// "TSCTIDX1" in little-endian
+    constexpr uint64_t initialCapacity = 1024;
+
+    // Zero marks an empty slot, so that key is stored as one.
+    uint64_t toSlotKey(uint64_t key) {
+        return key ? key : 1;
+    }
+
+    std::size_t fileSize(int file) {
+        struct stat status{};
+        if (fstat(file, &status) != 0)
+            throw IOError(std::string("Unable to stat cache file: ") + strerror(errno));
+        return static_cast<std::size_t>(status.st_size);
+    }
+
+    int openFile(const std::string &path, int flags = O_APPEND) {
+        int file = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | flags, 0644);
+        if (file < 0)
+            throw IOError("Unable to open cache file '" + path + "': " + strerror(errno));
+        return file;
+    }
+
+    void writeAll(int file, const void *data, std::size_t size) {
+        auto bytes = static_cast<const char *>(data);
+        while (size > 0) {
+            auto written = ::write(file, bytes, size);
+            if (written < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw IOError(std::string("Unable to write cache file: ") + strerror(errno));
+            }
+            bytes += written;
+            size -= static_cast<std::size_t>(written);
+        }
+    }
+
+    // Taken on the data file, since the index file is replaced when it grows.
+    class StoreLock {
+    public:
+        explicit StoreLock(int file) : file(file) { flock(file, LOCK_EX); }
+
+        ~StoreLock() { flock(file, LOCK_UN); }
+
+    private:
+        int file;
+    };
+
+}
+
+TranscriptCache::TranscriptCache(const std::string &directory) : directory(directory),
+                                                                 indexPath(directory + "/transcripts.index") {
+    std::filesystem::create_directories(directory);
+    dataFile = openFile(directory + "/transcripts.data");
+    openIndex();
+    INFO("Transcript cache '{}' holds {} entries", directory, header->count);
+}
+
+TranscriptCache::~TranscriptCache() {
+    unmapIndex();
+    close(indexFile);
+    close(dataFile);
+}
+
+// MurmurHash64A, reading the payload eight bytes at a time.
+uint64_t TranscriptCache::hash(const void *data, std::size_t size, uint64_t seed) {
+    constexpr uint64_t m = 0xc6a4a7935bd1e995ULL;
+    constexpr int r = 47;
+    uint64_t h = seed ^ (size * m);
+    auto bytes = static_cast<const unsigned char *>(data);
+    const auto end = bytes + (size / 8) * 8;
+    for (; bytes != end; bytes += 8) {
+        uint64_t k;
+        std::memcpy(&k, bytes, sizeof(k));
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+    switch (size & 7) {
+        case 7: h ^= uint64_t(bytes[6]) << 48; [[fallthrough]];
+        case 6: h ^= uint64_t(bytes[5]) << 40; [[fallthrough]];
+        case 5: h ^= uint64_t(bytes[4]) << 32; [[fallthrough]];
+        case 4: h ^= uint64_t(bytes[3]) << 24; [[fallthrough]];
+        case 3: h ^= uint64_t(bytes[2]) << 16; [[fallthrough]];
+        case 2: h ^= uint64_t(bytes[1]) << 8; [[fallthrough]];
+        case 1: h ^= uint64_t(bytes[0]);
+            h *= m;
+    }
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+uint64_t TranscriptCache::buildKey(const Audio &audio, const Configuration &configuration) {
+    uint64_t key = hash(audio.getData(), audio.getLengthInBytes(), audio.getSamplingRate());
+
+    std::string fields = configuration.getLanguage() + '\n' + configuration.getAsrVersion() + '\n' +
+                         std::to_string(configuration.getSampleRate()) + '\n' +
+                         std::to_string(configuration.getFormatting()) + std::to_string(configuration.getDiarization());
+    if (configuration.hasTopic()) {
+        fields += "\ntopic:" + configuration.getTopic();
+    } else if (configuration.hasGrammar()) {
+        auto grammar = configuration.getGrammar();
+        fields += "\ngrammar:" + std::to_string(grammar.getType()) + ':' + grammar.getContent();
+        auto compiled = grammar.getCompiledBytes();
+        fields += ':' + std::to_string(hash(compiled.data(), compiled.size(), 0));
+    }
+    // With candidates the transcript depends on the whole set the recognition chose from.
+    for (const auto &candidate: configuration.getCandidateLanguages())
+        fields += "\ncandidate-language:" + candidate;
+    for (const auto &candidate: configuration.getCandidateTopics())
+        fields += "\ncandidate-topic:" + candidate;
+    return hash(fields.data(), fields.size(), key);
+}
+
+bool TranscriptCache::lookup(uint64_t key, std::vector<RecognitionResult> &results) {
+    refreshIndex();
+    key = toSlotKey(key);
+    const auto slot = findSlot(key);
+    if (!slot || std::atomic_ref<uint64_t>(slot->key).load(std::memory_order_acquire) != key)
+        return false;
+    // A slot rewritten by another process while it is read fails the checksum.
+    const IndexEntry entry = *slot;
+    if (entry.offset + entry.length > fileSize(dataFile))
+        return false;
+    std::string value(entry.length, '\0');
+    if (pread(dataFile, value.data(), value.size(), static_cast<off_t>(entry.offset)) !=
+        static_cast<ssize_t>(value.size()) ||
+        static_cast<uint32_t>(hash(value.data(), value.size(), key)) != entry.checksum) {
+        WARN("Corrupted transcript cache entry at offset {}", entry.offset);
+        return false;
+    }
+    CachedTranscript transcript;
+    if (!transcript.ParseFromString(value))
+        return false;
+    results.assign(transcript.results().begin(), transcript.results().end());
+    return true;
+}
+
+void TranscriptCache::store(uint64_t key, const std::vector<RecognitionResult> &results) {
+    if (results.empty())
+        return;
+    CachedTranscript transcript;
+    for (const auto &result: results)
+        *transcript.add_results() = result;
+    const auto value = transcript.SerializeAsString();
+
+    StoreLock lock(dataFile);
+    refreshIndex();
+    key = toSlotKey(key);
+    const IndexEntry entry{key, fileSize(dataFile), static_cast<uint32_t>(value.size()),
+                           static_cast<uint32_t>(hash(value.data(), value.size(), key))};
+    writeAll(dataFile, value.data(), value.size());
+
+    auto slot = findSlot(key);
+    if (!slot || (slot->key == 0 && (header->count + 1) * 2 > header->capacity)) {
+        std::vector<IndexEntry> entries;
+        for (uint64_t i = 0; i < header->capacity; ++i)
+            if (slots[i].key != 0)
+                entries.emplace_back(slots[i]);
+        rebuildIndex(header->capacity * 2, entries);
+        slot = findSlot(key);
+    }
+    const bool added = slot->key == 0;
+    slot->offset = entry.offset;
+    slot->length = entry.length;
+    slot->checksum = entry.checksum;
+    // Published last, so a reader that finds the key also finds the rest of a new entry.
+    std::atomic_ref<uint64_t>(slot->key).store(key, std::memory_order_release);
+    if (added)
+        ++header->count;
+}
+
+TranscriptCache::IndexEntry *TranscriptCache::findSlot(uint64_t key) const {
+    // Keys are already hashes, their low bits pick the first slot.
+    const auto mask = header->capacity - 1;
+    for (uint64_t probe = 0, i = key & mask; probe < header->capacity; ++probe, i = (i + 1) & mask) {
+        const auto stored = std::atomic_ref<uint64_t>(slots[i].key).load(std::memory_order_acquire);
+        if (stored == key || stored == 0)
+            return &slots[i];
+    }
+    return nullptr;
+}
+
+void TranscriptCache::openIndex() {
+    StoreLock lock(dataFile);
+    indexFile = openFile(indexPath, 0);
+    if (mapIndex())
+        return;
+    // Nothing in an index that is not one can be trusted to point at a value, so the cache starts over.
+    if (fileSize(indexFile) > 0)
+        WARN("Invalid transcript cache index '{}', replaced with an empty one", indexPath);
+    rebuildIndex(initialCapacity, {});
+}
+
+void TranscriptCache::refreshIndex() {
+    struct stat byPath{}, opened{};
+    if (stat(indexPath.c_str(), &byPath) != 0 || fstat(indexFile, &opened) != 0)
+        throw IOError("Unable to stat transcript cache index '" + indexPath + "': " + strerror(errno));
+    if (byPath.st_ino == opened.st_ino && byPath.st_dev == opened.st_dev)
+        return;
+    close(indexFile);
+    indexFile = openFile(indexPath, 0);
+    if (!mapIndex())
+        throw IOError("Invalid transcript cache index '" + indexPath + "'");
+}
+
+void TranscriptCache::rebuildIndex(uint64_t capacity, const std::vector<IndexEntry> &entries) {
+    std::vector<char> table(sizeof(IndexHeader) + capacity * sizeof(IndexEntry), '\0');
+    auto newHeader = reinterpret_cast<IndexHeader *>(table.data());
+    auto newSlots = reinterpret_cast<IndexEntry *>(table.data() + sizeof(IndexHeader));
+    *newHeader = IndexHeader{indexMagic, capacity, 0, 0};
+    // Later entries of the same key replace earlier ones.
+    for (const auto &entry: entries) {
+        const auto key = toSlotKey(entry.key);
+        auto i = key & (capacity - 1);
+        while (newSlots[i].key != 0 && newSlots[i].key != key)
+            i = (i + 1) & (capacity - 1);
+        newHeader->count += newSlots[i].key == 0;
+        newSlots[i] = entry;
+        newSlots[i].key = key;
+    }
+
+    // Written aside and renamed over the index, so that readers only ever map a complete table.
+    const auto temporary = indexPath + ".tmp";
+    int file = open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (file < 0)
+        throw IOError("Unable to open cache file '" + temporary + "': " + strerror(errno));
+    try {
+        writeAll(file, table.data(), table.size());
+    } catch (...) {
+        close(file);
+        throw;
+    }
+    close(file);
+    if (rename(temporary.c_str(), indexPath.c_str()) != 0)
+        throw IOError("Unable to replace transcript cache index: " + std::string(strerror(errno)));
+    close(indexFile);
+    indexFile = openFile(indexPath, 0);
+    if (!mapIndex())
+        throw IOError("Invalid transcript cache index '" + indexPath + "'");
+}
+
+bool TranscriptCache::mapIndex() {
+    unmapIndex();
+    const auto size = fileSize(indexFile);
+    if (size < sizeof(IndexHeader))
+        return false;
+    auto mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, indexFile, 0);
+    if (mapping == MAP_FAILED)
+        throw IOError(std::string("Unable to map transcript cache index: ") + strerror(errno));
+    header = static_cast<IndexHeader *>(mapping);
+    slots = reinterpret_cast<IndexEntry *>(static_cast<char *>(mapping) + sizeof(IndexHeader));
+    mappedBytes = size;
+    const auto capacity = header->capacity;
+    if (header->magic != indexMagic || capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+        size != sizeof(IndexHeader) + capacity * sizeof(IndexEntry)) {
+        unmapIndex();
+        return false;
+    }
+    return true;
+}
+
+void TranscriptCache::unmapIndex() {
+    if (header)
+        munmap(header, mappedBytes);
+    header = nullptr;
+    slots = nullptr;
+    mappedBytes = 0;
+}
@@ -0,0 +1,354 @@
+#include "TranscriptStore.h"
+
+#include "gRpcExceptions.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <numeric>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace speechcenter::recognizer::v1;
+using namespace transcript;
+
+namespace {
+
+    constexpr char magic[4] = {'S', 'C', 'T', 'S'};
+    constexpr uint32_t version = 1;
+
+    // The layout of a file is that of the structs, which must not change with the compiler or the host.
+    static_assert(std::endian::native == std::endian::little, "Transcript files are little-endian");
+    static_assert(sizeof(Header) == 104 && sizeof(Block) == 20, "Transcript structs must not be padded");
+
+    // Each writer has its own temporary file, even when two of them replace the same transcript.
+    std::string temporaryPath(const std::string &path) {
+        static std::atomic<uint64_t> writes{0};
+        return path + "." + std::to_string(getpid()) + "." + std::to_string(writes++) + ".tmp";
+    }
+
+    uint32_t toMilliseconds(float seconds) {
+        return static_cast<uint32_t>(std::lround(std::max(0.0f, seconds) * 1000));
+    }
+
+    void putVarint(std::string &column, uint32_t value) {
+        while (value >= 0x80) {
+            column.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        column.push_back(static_cast<char>(value));
+    }
+
+    uint32_t zigzag(int32_t value) {
+        return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+    }
+
+    int32_t unzigzag(uint32_t value) {
+        return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+    }
+
+    // Reads varints from a column, refusing to run past its end.
+    class VarintReader {
+    public:
+        VarintReader(const char *position, const char *end) : position(position), end(end) {}
+
+        uint32_t next() {
+            uint32_t value = 0;
+            for (int shift = 0; shift < 35; shift += 7) {
+                if (position >= end)
+                    throw IOError("Truncated transcript column");
+                const auto byte = static_cast<uint8_t>(*position++);
+                value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+                if (!(byte & 0x80))
+                    return value;
+            }
+            throw IOError("Malformed varint in transcript column");
+        }
+
+        const char *position;
+        const char *end;
+    };
+
+}
+
+void TranscriptWriter::add(const RecognitionResult &result) {
+    if (!result.is_final() || result.alternatives().empty())
+        return;
+    for (const auto &word: result.alternatives(0).words()) {
+        auto [entry, inserted] = termIds.emplace(word.word(), static_cast<uint32_t>(terms.size()));
+        if (inserted)
+            terms.emplace_back(&entry->first);
+        ids.emplace_back(entry->second);
+        const auto start = toMilliseconds(word.start_time());
+        startsMs.emplace_back(start);
+        endsMs.emplace_back(std::max(start, toMilliseconds(word.end_time())));
+        confidences.emplace_back(static_cast<uint8_t>(std::lround(std::clamp(word.confidence(), 0.0f, 1.0f) * 255)));
+        speakers.emplace_back(word.speaker_id());
+    }
+}
+
+std::size_t TranscriptWriter::countWords() const {
+    return ids.size();
+}
+
+void TranscriptWriter::write(const std::string &path) const {
+    // Ids are given in sorted order, so that a reader finds a term by binary search.
+    std::vector<uint32_t> sorted(terms.size());
+    std::iota(sorted.begin(), sorted.end(), 0);
+    std::sort(sorted.begin(), sorted.end(), [this](uint32_t a, uint32_t b) { return *terms[a] < *terms[b]; });
+    std::vector<uint32_t> sortedId(terms.size());
+    std::vector<uint32_t> termOffsets{0};
+    std::string termBytes;
+    for (uint32_t i = 0; i < sorted.size(); ++i) {
+        sortedId[sorted[i]] = i;
+        termBytes += *terms[sorted[i]];
+        termOffsets.emplace_back(static_cast<uint32_t>(termBytes.size()));
+    }
+
+    std::string idColumn, startColumn, endColumn, speakerColumn;
+    std::vector<Block> blocks;
+    uint32_t longestWordMs = 0, speakerRuns = 0;
+    std::size_t runStart = 0;
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        if (i % blockWords == 0)
+            blocks.push_back({static_cast<uint32_t>(i), startsMs[i], static_cast<uint32_t>(idColumn.size()),
+                              static_cast<uint32_t>(startColumn.size()), static_cast<uint32_t>(endColumn.size())});
+        putVarint(idColumn, sortedId[ids[i]]);
+        putVarint(startColumn, zigzag(static_cast<int32_t>(startsMs[i] - (i > 0 ? startsMs[i - 1] : 0))));
+        putVarint(endColumn, endsMs[i] - startsMs[i]);
+        longestWordMs = std::max(longestWordMs, endsMs[i] - startsMs[i]);
+        if (i + 1 == ids.size() || speakers[i + 1] != speakers[i]) {
+            putVarint(speakerColumn, speakers[i]);
+            putVarint(speakerColumn, static_cast<uint32_t>(i + 1 - runStart));
+            runStart = i + 1;
+            ++speakerRuns;
+        }
+    }
+
+    Header header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.words = static_cast<uint32_t>(ids.size());
+    header.terms = static_cast<uint32_t>(terms.size());
+    header.speakerRuns = speakerRuns;
+    header.blocks = static_cast<uint32_t>(blocks.size());
+    header.longestWordMs = longestWordMs;
+    header.termOffsets = sizeof(Header);
+    header.termBytes = header.termOffsets + termOffsets.size() * sizeof(uint32_t);
+    header.ids = header.termBytes + termBytes.size();
+    header.starts = header.ids + idColumn.size();
+    header.ends = header.starts + startColumn.size();
+    header.confidences = header.ends + endColumn.size();
+    header.speakers = header.confidences + confidences.size();
+    // The skip index is read in place, so it is aligned.
+    const auto padding = (4 - (header.speakers + speakerColumn.size()) % 4) % 4;
+    header.blockIndex = header.speakers + speakerColumn.size() + padding;
+    header.fileSize = header.blockIndex + blocks.size() * sizeof(Block);
+
+    const auto temporary = temporaryPath(path);
+    {
+        std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+        output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        output.write(reinterpret_cast<const char *>(termOffsets.data()),
+                     static_cast<std::streamsize>(termOffsets.size() * sizeof(uint32_t)));
+        output << termBytes << idColumn << startColumn << endColumn;
+        output.write(reinterpret_cast<const char *>(confidences.data()),
+                     static_cast<std::streamsize>(confidences.size()));
+        output << speakerColumn << std::string(padding, '\0');
+        output.write(reinterpret_cast<const char *>(blocks.data()),
+                     static_cast<std::streamsize>(blocks.size() * sizeof(Block)));
+        if (!output) {
+            std::remove(temporary.c_str());
+            throw IOError("Unable to write transcript '" + temporary + "'");
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        throw IOError("Unable to replace transcript '" + path + "'");
+    }
+}
+
+// Decodes the columns word by word, from the start of a block.
+class TranscriptReader::Cursor {
+public:
+    explicit Cursor(const TranscriptReader &reader) :
+            reader(reader),
+            ids(reader.data + reader.header.ids, reader.data + reader.header.starts),
+            starts(reader.data + reader.header.starts, reader.data + reader.header.ends),
+            ends(reader.data + reader.header.ends, reader.data + reader.header.confidences) {}
+
+    void seek(uint32_t block) {
+        const auto &entry = reader.blocks[block];
+        index = entry.firstWord;
+        ids.position = reader.data + reader.header.ids + entry.ids;
+        starts.position = reader.data + reader.header.starts + entry.starts;
+        ends.position = reader.data + reader.header.ends + entry.ends;
+        startMs = entry.startMs;
+        blockStart = true;
+    }
+
+    uint32_t position() const {
+        return index;
+    }
+
+    Word next() {
+        const auto id = ids.next();
+        const auto delta = unzigzag(starts.next());
+        // The first word of a block has its absolute start in the index.
+        if (!blockStart)
+            startMs += delta;
+        blockStart = false;
+        const auto endMs = startMs + ends.next();
+        if (id >= reader.header.terms)
+            throw IOError("Unknown term id in transcript '" + reader.path + "'");
+        const auto confidence = static_cast<uint8_t>(reader.data[reader.header.confidences + index]);
+        Word word{reader.term(id), startMs / 1000.0, endMs / 1000.0, confidence / 255.0f, reader.speakerOf(index),
+                  index};
+        ++index;
+        return word;
+    }
+
+private:
+    const TranscriptReader &reader;
+    VarintReader ids, starts, ends;
+    uint32_t index{0};
+    uint32_t startMs{0};
+    bool blockStart{false};
+};
+
+TranscriptReader::TranscriptReader(const std::string &path) : path(path) {
+    int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0)
+        throw IOError("Unable to open transcript '" + path + "': " + strerror(errno));
+    struct stat status{};
+    if (fstat(file, &status) != 0 || static_cast<std::size_t>(status.st_size) < sizeof(Header)) {
+        close(file);
+        throw IOError("Transcript '" + path + "' is too short");
+    }
+    size = static_cast<std::size_t>(status.st_size);
+    auto mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, file, 0);
+    close(file);
+    if (mapping == MAP_FAILED)
+        throw IOError("Unable to map transcript '" + path + "': " + strerror(errno));
+    data = static_cast<const char *>(mapping);
+
+    std::memcpy(&header, data, sizeof(header));
+    const bool valid = std::memcmp(header.magic, magic, sizeof(magic)) == 0 && header.version == version &&
+                       header.fileSize == size && header.termOffsets == sizeof(Header) &&
+                       header.termBytes == header.termOffsets + (header.terms + 1ull) * sizeof(uint32_t) &&
+                       header.termBytes <= header.ids && header.ids <= header.starts &&
+                       header.starts <= header.ends && header.ends <= header.confidences &&
+                       header.confidences + header.words <= header.speakers && header.speakers <= header.blockIndex &&
+                       header.blockIndex % alignof(Block) == 0 &&
+                       header.blockIndex + header.blocks * sizeof(Block) == size &&
+                       header.blocks == (header.words + blockWords - 1) / blockWords;
+    if (!valid) {
+        munmap(const_cast<char *>(data), size);
+        throw IOError("'" + path + "' is not a transcript file of version " + std::to_string(version));
+    }
+    blocks = reinterpret_cast<const Block *>(data + header.blockIndex);
+    // A cursor seeks straight to these positions, so every block must begin inside its columns.
+    for (uint32_t i = 0; i < header.blocks; ++i) {
+        const auto &entry = blocks[i];
+        if (entry.firstWord != i * blockWords || entry.ids >= header.starts - header.ids ||
+            entry.starts >= header.ends - header.starts || entry.ends >= header.confidences - header.ends) {
+            munmap(const_cast<char *>(data), size);
+            throw IOError("Malformed skip index in transcript '" + path + "'");
+        }
+    }
+
+    VarintReader runs(data + header.speakers, data + header.blockIndex);
+    uint32_t runEnd = 0;
+    try {
+        for (uint32_t i = 0; i < header.speakerRuns; ++i) {
+            speakerRunIds.emplace_back(runs.next());
+            runEnd += runs.next();
+            speakerRunEnds.emplace_back(runEnd);
+        }
+    } catch (IOError &) {
+        munmap(const_cast<char *>(data), size);
+        throw;
+    }
+}
+
+TranscriptReader::~TranscriptReader() {
+    munmap(const_cast<char *>(data), size);
+}
+
+std::size_t TranscriptReader::countWords() const {
+    return header.words;
+}
+
+std::vector<Word> TranscriptReader::between(double from, double to) const {
+    std::vector<Word> words;
+    if (header.words == 0 || to < from)
+        return words;
+    // A word that started up to the longest word before the range may still be spoken in it.
+    const auto earliest = std::max(0.0, from * 1000 - header.longestWordMs);
+    auto block = std::upper_bound(blocks, blocks + header.blocks, earliest, [](double ms, const Block &entry) {
+        return ms < entry.startMs;
+    });
+    Cursor cursor(*this);
+    cursor.seek(block == blocks ? 0 : static_cast<uint32_t>(block - blocks - 1));
+    while (cursor.position() < header.words) {
+        auto word = cursor.next();
+        if (word.startTime > to)
+            break;
+        if (word.endTime >= from)
+            words.emplace_back(word);
+    }
+    return words;
+}
+
+std::vector<Word> TranscriptReader::find(const std::string &text) const {
+    std::vector<Word> words;
+    uint32_t low = 0, high = header.terms;
+    while (low < high) {
+        const auto middle = low + (high - low) / 2;
+        if (term(middle) < text)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    if (low == header.terms || term(low) != text)
+        return words;
+
+    // Only the id column is scanned, the other ones are decoded for the matches alone.
+    std::vector<uint32_t> matches;
+    VarintReader ids(data + header.ids, data + header.starts);
+    for (uint32_t index = 0; index < header.words; ++index)
+        if (ids.next() == low)
+            matches.emplace_back(index);
+
+    Cursor cursor(*this);
+    bool positioned = false;
+    for (const auto index: matches) {
+        if (!positioned || index / blockWords != (cursor.position() - 1) / blockWords) {
+            cursor.seek(index / blockWords);
+            positioned = true;
+        }
+        while (cursor.position() < index)
+            cursor.next();
+        words.emplace_back(cursor.next());
+    }
+    return words;
+}
+
+std::string_view TranscriptReader::term(uint32_t id) const {
+    uint32_t offsets[2];
+    std::memcpy(offsets, data + header.termOffsets + id * sizeof(uint32_t), sizeof(offsets));
+    if (offsets[0] > offsets[1] || header.termBytes + offsets[1] > header.ids)
+        throw IOError("Malformed dictionary in transcript '" + path + "'");
+    return {data + header.termBytes + offsets[0], offsets[1] - offsets[0]};
+}
+
+uint32_t TranscriptReader::speakerOf(uint32_t index) const {
+    auto run = std::upper_bound(speakerRunEnds.begin(), speakerRunEnds.end(), index);
+    return run == speakerRunEnds.end() ? 0 : speakerRunIds[run - speakerRunEnds.begin()];
+}
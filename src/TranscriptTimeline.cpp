@@ -0,0 +1,107 @@
+#include "TranscriptTimeline.h"
+
+#include <algorithm>
+#include <sstream>
+
+using namespace speechcenter::recognizer::v1;
+
+namespace {
+
+    bool sameText(const TranscriptTimeline::Word &word, const TranscriptTimeline::Word &revised) {
+        return word.text == revised.text;
+    }
+
+    // Takes the timing and scores of the revised word, telling whether they differed.
+    bool rescore(TranscriptTimeline::Word &word, const TranscriptTimeline::Word &revised) {
+        if (word.startTime == revised.startTime && word.endTime == revised.endTime &&
+            word.confidence == revised.confidence && word.speaker == revised.speaker)
+            return false;
+        word.startTime = revised.startTime;
+        word.endTime = revised.endTime;
+        word.confidence = revised.confidence;
+        word.speaker = revised.speaker;
+        return true;
+    }
+
+}
+
+void TranscriptTimeline::subscribe(Subscriber subscriber) {
+    subscribers.push_back(std::move(subscriber));
+}
+
+void TranscriptTimeline::apply(const RecognitionResult &result) {
+    revision.clear();
+    if (!result.alternatives().empty()) {
+        const auto &alternative = result.alternatives(0);
+        if (alternative.words().empty()) {
+            // Without word timings, the words of the transcript.
+            std::istringstream transcript(alternative.transcript());
+            std::string text;
+            while (transcript >> text)
+                revision.push_back({std::move(text), 0, 0, alternative.confidence(), 0});
+        } else
+            for (const auto &word: alternative.words())
+                revision.push_back({word.word(), word.start_time(), word.end_time(), word.confidence(),
+                                    word.speaker_id()});
+    }
+
+    const auto tail = words.begin() + static_cast<std::ptrdiff_t>(frozen);
+    const auto oldLength = static_cast<std::size_t>(words.end() - tail);
+    const auto shortest = std::min(oldLength, revision.size());
+    const auto prefix = static_cast<std::size_t>(
+            std::mismatch(tail, tail + static_cast<std::ptrdiff_t>(shortest), revision.begin(), sameText).first - tail);
+    const auto suffix = static_cast<std::size_t>(
+            std::mismatch(words.rbegin(), words.rbegin() + static_cast<std::ptrdiff_t>(shortest - prefix),
+                          revision.rbegin(), sameText).first - words.rbegin());
+
+    bool rescored = false;
+    for (std::size_t i = 0; i < prefix; ++i)
+        rescored |= rescore(words[frozen + i], revision[i]);
+    for (std::size_t i = 1; i <= suffix; ++i)
+        rescored |= rescore(words[words.size() - i], revision[revision.size() - i]);
+
+    const auto first = frozen + prefix;
+    const auto removed = oldLength - prefix - suffix;
+    const auto insertedEnd = revision.size() - suffix;
+    const bool changed = removed > 0 || insertedEnd > prefix;
+    if (changed) {
+        // Only the changed range moves; the words the revision shares with the tail stay where they are.
+        auto from = words.begin() + static_cast<std::ptrdiff_t>(first);
+        auto replaced = std::min(removed, insertedEnd - prefix);
+        std::move(revision.begin() + static_cast<std::ptrdiff_t>(prefix),
+                  revision.begin() + static_cast<std::ptrdiff_t>(prefix + replaced), from);
+        if (removed > replaced)
+            words.erase(from + static_cast<std::ptrdiff_t>(replaced), from + static_cast<std::ptrdiff_t>(removed));
+        else
+            words.insert(from + static_cast<std::ptrdiff_t>(replaced),
+                         std::make_move_iterator(revision.begin() + static_cast<std::ptrdiff_t>(prefix + replaced)),
+                         std::make_move_iterator(revision.begin() + static_cast<std::ptrdiff_t>(insertedEnd)));
+    }
+    if (result.is_final())
+        frozen = words.size();
+    if (!changed && !rescored && !result.is_final())
+        return;
+    const Diff diff{first, removed,
+                    std::span<const Word>(words.data() + first, insertedEnd - prefix), result.is_final()};
+    for (const auto &subscriber: subscribers)
+        subscriber(diff);
+}
+
+const std::vector<TranscriptTimeline::Word> &TranscriptTimeline::getWords() const {
+    return words;
+}
+
+std::size_t TranscriptTimeline::countFrozen() const {
+    return frozen;
+}
+
+std::string TranscriptTimeline::text(std::size_t first) const {
+    std::string text;
+    for (auto word = words.begin() + static_cast<std::ptrdiff_t>(std::min(first, words.size()));
+         word != words.end(); ++word) {
+        if (!text.empty())
+            text.push_back(' ');
+        text += word->text;
+    }
+    return text;
+}
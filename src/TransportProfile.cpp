@@ -0,0 +1,51 @@
+#include "TransportProfile.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+    constexpr int KiB = 1024;
+    constexpr int MiB = 1024 * KiB;
+
+    const std::vector<TransportProfile> profiles = {
+            {"default", GRPC_COMPRESS_NONE, 0, true, 0, 0, false},
+            // Round trips are short, so the default window keeps up and BDP pings are only overhead.
+            {"lan", GRPC_COMPRESS_NONE, 0, false, 0, 0, false},
+            // A long round trip needs a window of a few seconds of audio to keep the link busy.
+            {"wan", GRPC_COMPRESS_NONE, 4 * MiB, true, 1 * MiB, 16 * MiB, true},
+            // Bytes cost more than CPU: gzip the audio and send it in as few packets as possible.
+            {"low-bandwidth", GRPC_COMPRESS_GZIP, 1 * MiB, true, 256 * KiB, 16 * MiB, true}};
+
+}
+
+const TransportProfile &TransportProfile::byName(const std::string &name) {
+    auto profile = std::find_if(profiles.begin(), profiles.end(),
+                                [&name](const TransportProfile &profile) { return profile.name == name; });
+    if (profile == profiles.end())
+        throw std::runtime_error("Unknown transport profile '" + name + "'");
+    return *profile;
+}
+
+std::vector<std::string> TransportProfile::names() {
+    std::vector<std::string> names;
+    for (const auto &profile: profiles)
+        names.push_back(profile.name);
+    return names;
+}
+
+void TransportProfile::apply(grpc::ChannelArguments &arguments) const {
+    if (streamWindow > 0)
+        arguments.SetInt(GRPC_ARG_HTTP2_STREAM_LOOKAHEAD_BYTES, streamWindow);
+    if (!bdpProbe)
+        arguments.SetInt(GRPC_ARG_HTTP2_BDP_PROBE, 0);
+    if (writeBufferSize > 0)
+        arguments.SetInt(GRPC_ARG_HTTP2_WRITE_BUFFER_SIZE, writeBufferSize);
+    if (maxMessageSize > 0)
+        arguments.SetMaxReceiveMessageSize(maxMessageSize);
+}
+
+void TransportProfile::apply(grpc::ClientContext &context) const {
+    if (compression != GRPC_COMPRESS_NONE)
+        context.set_compression_algorithm(compression);
+}
@@ -0,0 +1,88 @@
+#include "WireFormat.h"
+
+#include <grpc/slice.h>
+#include <grpcpp/impl/codegen/proto_utils.h>
+#include <grpcpp/impl/codegen/rpc_method.h>
+
+#include <type_traits>
+
+using namespace speechcenter::recognizer::v1;
+
+namespace {
+
+    constexpr std::size_t maxHeaderLength = 1 + 10;// tag and varint length
+
+    std::size_t writeHeader(std::size_t audioLength, char *header) {
+        // Field 2 of the request, length-delimited.
+        header[0] = static_cast<char>(RecognitionStreamingRequest::kAudioFieldNumber << 3 | 2);
+        std::size_t length = 1;
+        do {
+            auto byte = static_cast<uint8_t>(audioLength & 0x7f);
+            audioLength >>= 7;
+            header[length++] = static_cast<char>(audioLength ? byte | 0x80 : byte);
+        } while (audioLength);
+        return length;
+    }
+
+    wire::Frame buildFrame(const void *data, std::size_t length, void *owner, void (*release)(void *)) {
+        char header[maxHeaderLength];
+        grpc::Slice slices[2] = {
+                grpc::Slice(header, writeHeader(length, header)),
+                grpc::Slice(grpc_slice_new_with_user_data(const_cast<void *>(data), length, release, owner),
+                            grpc::Slice::STEAL_REF)};
+        return {grpc::ByteBuffer(slices, 2), length};
+    }
+
+}
+
+namespace wire {
+
+    Frame serialize(const RecognitionStreamingRequest &request) {
+        Frame frame;
+        bool ownBuffer;
+        grpc::SerializationTraits<RecognitionStreamingRequest>::Serialize(request, &frame.buffer, &ownBuffer);
+        frame.audioBytes = request.audio().size();
+        return frame;
+    }
+
+    Frame audioFrame(const void *data, std::size_t length, std::shared_ptr<const void> owner) {
+        return buildFrame(data, length, new std::shared_ptr<const void>(std::move(owner)), [](void *owner) {
+            delete static_cast<std::shared_ptr<const void> *>(owner);
+        });
+    }
+
+    Frame audioFrame(std::string audio) {
+        auto owner = new std::string(std::move(audio));
+        return buildFrame(owner->data(), owner->size(), owner, [](void *owner) {
+            delete static_cast<std::string *>(owner);
+        });
+    }
+
+    bool parse(grpc::ByteBuffer &buffer, RecognitionStreamingRequest &request) {
+        return grpc::SerializationTraits<RecognitionStreamingRequest>::Deserialize(&buffer, &request).ok();
+    }
+
+    bool parse(grpc::ByteBuffer &buffer, RecognitionStreamingResponse &response) {
+        return grpc::SerializationTraits<RecognitionStreamingResponse>::Deserialize(&buffer, &response).ok();
+    }
+
+    std::unique_ptr<Stream> openRecognitionStream(const std::shared_ptr<grpc::Channel> &channel,
+                                                  grpc::ClientContext *context) {
+        // GenericStub only streams asynchronously, so this is the one place that uses gRPC internals, the same ones
+        // the generated stub uses. They are not a stable API: if an upgrade changes them, fail here at compile time.
+        using Method = grpc::internal::RpcMethod;
+        using Factory = grpc::internal::ClientReaderWriterFactory<grpc::ByteBuffer, grpc::ByteBuffer>;
+        static_assert(std::is_constructible_v<Method, const char *, Method::RpcType>,
+                      "grpc::internal::RpcMethod changed, check openRecognitionStream against this gRPC version");
+        static_assert(std::is_same_v<decltype(&Factory::Create),
+                                     Stream *(*) (grpc::ChannelInterface *, const Method &, grpc::ClientContext *)>,
+                      "grpc::internal::ClientReaderWriterFactory changed, check openRecognitionStream against this "
+                      "gRPC version");
+
+        // Same path as the generated stub. Like a GenericStub call, it is not registered on the channel.
+        static const std::string method = "/" + std::string(Recognizer::service_full_name()) + "/StreamingRecognize";
+        Method rpcMethod(method.c_str(), Method::BIDI_STREAMING);
+        return std::unique_ptr<Stream>(Factory::Create(channel.get(), rpcMethod, context));
+    }
+
+}
@@ -21,4 +21,7 @@ MultipleLanguageModelsNotImplemented::MultipleLanguageModelsNotImplemented() : G
 
 StreamException::StreamException(const std::string message) : GrpcException("Stream error. Cannot write to stream. (" + message + ")") {}
 
+EndpointUnavailable::EndpointUnavailable(const std::string &host, const std::string &message) : StreamException(
+        "Endpoint '" + host + "' unavailable: " + message) {}
+
 IOError::IOError(const std::string &message) : GrpcException(message) {}
@@ -1,17 +1,378 @@
-
+#include "AudioPrefetcher.h"
+#include "ConcurrencyLimiter.h"
 #include "Configuration.h"
+#include "JobScheduler.h"
+#include "KeywordSpotter.h"
+#include "MetricsFile.h"
 #include "RecognitionClient.h"
+#include "RtpIngest.h"
+#include "SpeculativeRecognition.h"
+#include "TranscriptCache.h"
+#include "TranscriptStore.h"
+#include "TranscriptTimeline.h"
 #include "gRpcExceptions.h"
 #include "logger.h"
 
+#include <atomic>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+    RtpIngest *activeIngest = nullptr;
+
+    void stopIngest(int) {
+        if (activeIngest)
+            activeIngest->stop();
+    }
+
+    std::shared_ptr<const KeywordAutomaton> loadKeywords(const Configuration &configuration) {
+        if (configuration.getKeywordsPath().empty())
+            return nullptr;
+        auto keywords = KeywordAutomaton::load(configuration.getKeywordsPath());
+        INFO("Spotting {} keyword phrases", keywords->countPhrases());
+        return keywords;
+    }
+
+    // Alerts of the keywords heard in the results of one audio or flow, none if no keywords are configured.
+    std::unique_ptr<KeywordSpotter> spotKeywords(const std::shared_ptr<const KeywordAutomaton> &keywords,
+                                                 const std::string &source) {
+        if (!keywords)
+            return nullptr;
+        return std::make_unique<KeywordSpotter>(keywords, [source](const KeywordSpotter::Hit &hit) {
+            WARN("[{}] Keyword '{}' at {:.2f}-{:.2f} s, speaker {}{}", source, hit.phrase, hit.startTime,
+                 hit.endTime, hit.speaker, hit.final ? "" : " (interim)");
+        });
+    }
+
+    // Logs the revisions of the segment being spoken at debug level and, if asked, every segment once it is final.
+    std::unique_ptr<TranscriptTimeline> followTranscript(const std::string &source, bool logSegments) {
+        auto timeline = std::make_unique<TranscriptTimeline>();
+        std::size_t segment = 0;
+        timeline->subscribe([timeline = timeline.get(), source, logSegments, segment](
+                const TranscriptTimeline::Diff &diff) mutable {
+            if (diff.final) {
+                if (logSegments)
+                    INFO("[{}] {}", source, timeline->text(segment));
+                segment = timeline->countFrozen();
+            } else if (diff.removed > 0 || !diff.inserted.empty())
+                DEBUG("[{}] words {}-{}: {}", source, diff.first, diff.first + diff.removed,
+                      timeline->text(diff.first));
+        });
+        return timeline;
+    }
+
+    // Recognizes every RTP flow live on its own session until interrupted.
+    int ingestRtp(const Configuration &configuration) {
+        RecognitionClient client(configuration);
+        const auto keywords = loadKeywords(configuration);
+        std::list<std::future<void>> sessions;
+        RtpIngest ingest(configuration.getRtpPorts(), std::chrono::milliseconds(configuration.getJitterDelay()),
+                         std::chrono::milliseconds(configuration.getRtpIdleTimeout()),
+                         [&](const std::string &flow, std::shared_ptr<LiveAudio> audio) {
+                             sessions.remove_if([](const std::future<void> &session) {
+                                 return session.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+                             });
+                             sessions.emplace_back(std::async(std::launch::async, [&client, flow, audio, keywords] {
+                                 auto spotter = spotKeywords(keywords, flow);
+                                 auto timeline = followTranscript(flow, true);
+                                 try {
+                                     client.createLiveSession(audio, [&](const RecognitionResult &result) {
+                                         if (spotter)
+                                             spotter->onResult(result);
+                                         timeline->apply(result);
+                                     })->run();
+                                 } catch (std::exception &e) {
+                                     ERROR("'{}': {}", flow, e.what());
+                                 }
+                             }));
+                         });
+        activeIngest = &ingest;
+        std::signal(SIGINT, stopIngest);
+        std::signal(SIGTERM, stopIngest);
+        ingest.run();
+        activeIngest = nullptr;
+        for (auto &session: sessions)
+            session.wait();
+        return 0;
+    }
+
+    bool isPushback(grpc::StatusCode code) {
+        return code == grpc::StatusCode::RESOURCE_EXHAUSTED || code == grpc::StatusCode::UNAVAILABLE;
+    }
+
+    // Every combination of the candidate languages and topics, empty fields standing for the configured ones.
+    std::vector<SpeculativeRecognition::Candidate> buildCandidates(const Configuration &configuration) {
+        auto languages = configuration.getCandidateLanguages();
+        auto topics = configuration.getCandidateTopics();
+        if (languages.empty())
+            languages.emplace_back();
+        if (topics.empty())
+            topics.emplace_back();
+        std::vector<SpeculativeRecognition::Candidate> candidates;
+        for (const auto &language: languages)
+            for (const auto &topic: topics)
+                candidates.push_back({language, topic});
+        return candidates;
+    }
+
+    double toSeconds(std::chrono::microseconds duration) {
+        return std::chrono::duration<double>(duration).count();
+    }
+
+    // Orders the audio files as configured, from their header durations, and predicts how long the run takes.
+    std::vector<std::string> scheduleFiles(const Configuration &configuration, std::chrono::microseconds &predicted) {
+        const auto paths = configuration.getAudioPaths();
+        predicted = std::chrono::microseconds(0);
+        if (paths.size() < 2)
+            return paths;
+        const auto priorities = configuration.getAudioPriorities();
+        const JobScheduler scheduler(configuration.getConcurrency(), configuration.getSchedule() == "longest-first"
+                                                                     ? JobScheduler::Order::LongestFirst
+                                                                     : JobScheduler::Order::Listed);
+        std::vector<JobScheduler::Job> jobs;
+        for (std::size_t i = 0; i < paths.size(); ++i) {
+            auto duration = std::chrono::microseconds(0);
+            try {
+                duration = Audio::probeDuration(paths[i]);
+            } catch (std::exception &e) {
+                // Reported again, and counted as a failure, when the file is decoded.
+                WARN(e.what());
+            }
+            jobs.push_back({paths[i], duration, priorities[i]});
+        }
+        const auto ordered = scheduler.schedule(jobs);
+        predicted = scheduler.predictMakespan(ordered);
+        // The concurrency limiter starts at one session and only opens up to --concurrency as streams succeed.
+        INFO("Predicted makespan at least {:.1f} s with up to {} sessions at a time, {:.1f} s in listing order.",
+             toSeconds(predicted), configuration.getConcurrency(), toSeconds(scheduler.predictMakespan(jobs)));
+        std::vector<std::string> orderedPaths;
+        for (const auto &job: ordered)
+            orderedPaths.emplace_back(job.path);
+        return orderedPaths;
+    }
+
+    // Checks the audio before anything is streamed, as configured. False if the file must not be recognized.
+    bool passesPreflight(const Configuration &configuration, const std::string &path, const Audio &audio,
+                         std::ofstream &report) {
+        if (configuration.getPreflight() == "off" && !report.is_open())
+            return true;
+        const auto problems = audio.getReport().findProblems(configuration.getSampleRate());
+        if (report.is_open()) {
+            audio.getReport().writeTsv(report, path, problems);
+            report.flush();
+        }
+        if (configuration.getPreflight() == "off" || problems.empty())
+            return true;
+        std::string description;
+        for (const auto &problem: problems)
+            description += (description.empty() ? "" : "; ") + problem;
+        if (configuration.getPreflight() == "skip") {
+            ERROR("'{}' skipped: {}", path, description);
+            return false;
+        }
+        WARN("'{}' may not be recognized: {}", path, description);
+        return true;
+    }
+
+    // Names the transcript of every audio <audio name>.sct. Audios of the same name, e.g. a/call.wav and b/call.wav or
+    // call.wav and call.flac, would overwrite each other's transcript, so all but the first listed get a number.
+    std::unordered_map<std::string, std::string> nameTranscripts(const std::vector<std::string> &audioPaths) {
+        std::unordered_map<std::string, std::string> names;
+        std::unordered_set<std::string> taken;
+        std::vector<std::string> renamed;
+        for (const auto &audioPath: audioPaths) {
+            if (names.count(audioPath))
+                continue;
+            const auto name = std::filesystem::path(audioPath).stem().string() + ".sct";
+            if (taken.insert(name).second)
+                names.emplace(audioPath, name);
+            else
+                renamed.emplace_back(audioPath);
+        }
+        for (const auto &audioPath: renamed) {
+            if (names.count(audioPath))
+                continue;
+            const auto stem = std::filesystem::path(audioPath).stem().string();
+            int number = 2;
+            while (taken.count(stem + "-" + std::to_string(number) + ".sct"))
+                ++number;
+            const auto name = stem + "-" + std::to_string(number) + ".sct";
+            taken.insert(name);
+            WARN("'{}' has the same name as another audio, its transcript is named '{}'", audioPath, name);
+            names.emplace(audioPath, name);
+        }
+        return names;
+    }
+
+    // Writes the words of the final results to <transcript-dir>/<transcript name>, if configured.
+    void writeTranscript(const Configuration &configuration, const std::string &audioPath,
+                         const std::unordered_map<std::string, std::string> &transcriptNames,
+                         const TranscriptWriter &transcript) {
+        if (configuration.getTranscriptDirectory().empty())
+            return;
+        const auto path =
+                std::filesystem::path(configuration.getTranscriptDirectory()) / transcriptNames.at(audioPath);
+        transcript.write(path.string());
+        INFO("{} words of '{}' written to '{}'", transcript.countWords(), audioPath, path.string());
+    }
+
+    // Recognizes the audio files, as many at a time as the concurrency limiter allows.
+    int recognizeFiles(const Configuration &configuration) {
+        std::unique_ptr<TranscriptCache> cache;
+        if (!configuration.getCacheDirectory().empty())
+            cache = std::make_unique<TranscriptCache>(configuration.getCacheDirectory());
+        std::mutex cacheMutex;
+        std::unique_ptr<MetricsFile> metrics;
+        if (!configuration.getMetricsPath().empty())
+            metrics = std::make_unique<MetricsFile>(configuration.getMetricsPath());
+        // Created on the first cache miss, so a fully cached run never asks for a token nor opens a channel.
+        std::unique_ptr<RecognitionClient> client;
+
+        ConcurrencyLimiter limiter(configuration.getConcurrency(), [&metrics](double limit, std::size_t inFlight) {
+            if (!metrics)
+                return;
+            metrics->set("speech_center_concurrency_limit", "Sessions allowed in flight by the adaptive limiter.", limit);
+            metrics->set("speech_center_sessions_in_flight", "Sessions currently streaming.", inFlight);
+            try {
+                metrics->write();
+            } catch (std::exception &e) {
+                WARN(e.what());
+            }
+        });
+        std::unordered_map<std::string, std::string> transcriptNames;
+        if (!configuration.getTranscriptDirectory().empty()) {
+            std::filesystem::create_directories(configuration.getTranscriptDirectory());
+            transcriptNames = nameTranscripts(configuration.getAudioPaths());
+        }
+        std::ofstream preflightReport;
+        if (!configuration.getPreflightReportPath().empty()) {
+            preflightReport.open(configuration.getPreflightReportPath());
+            if (!preflightReport)
+                throw IOError("Unable to write the pre-flight report '" + configuration.getPreflightReportPath() + "'");
+            AudioReport::writeTsvHeader(preflightReport);
+        }
+        const auto candidates = buildCandidates(configuration);
+        const auto keywords = loadKeywords(configuration);
+        const auto start = std::chrono::steady_clock::now();
+        std::chrono::microseconds predicted;
+        const auto paths = scheduleFiles(configuration, predicted);
+        AudioPrefetcher prefetcher(paths, configuration.getReadAhead(),
+                                   configuration.getPreflight() != "off" || preflightReport.is_open());
+        std::atomic<int> failures{0};
+        std::list<std::future<void>> sessions;
+        for (const auto &path: paths) {
+            try {
+                auto audio = prefetcher.next();
+                if (!passesPreflight(configuration, path, *audio, preflightReport)) {
+                    ++failures;
+                    continue;
+                }
+                uint64_t key = 0;
+                if (cache) {
+                    key = TranscriptCache::buildKey(*audio, configuration);
+                    std::vector<RecognitionResult> results;
+                    std::lock_guard<std::mutex> lock(cacheMutex);
+                    if (cache->lookup(key, results)) {
+                        INFO("Transcript of '{}' found in cache", path);
+                        TranscriptWriter transcript;
+                        auto spotter = spotKeywords(keywords, path);
+                        for (const auto &result: results) {
+                            RecognitionClient::printResult(result);
+                            transcript.add(result);
+                            if (spotter)
+                                spotter->onResult(result);
+                        }
+                        writeTranscript(configuration, path, transcriptNames, transcript);
+                        continue;
+                    }
+                }
+                if (!client)
+                    client = std::make_unique<RecognitionClient>(configuration);
+
+                auto ticket = limiter.acquire();
+                sessions.remove_if([](const std::future<void> &session) {
+                    return session.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+                });
+                sessions.emplace_back(std::async(std::launch::async, [&, path, audio, key, ticket] {
+                    std::vector<RecognitionResult> results;
+                    TranscriptWriter transcript;
+                    auto spotter = spotKeywords(keywords, path);
+                    // Final results are already printed by the session.
+                    auto timeline = followTranscript(path, false);
+                    auto keepFinal = [&](const RecognitionResult &result) {
+                        if (spotter)
+                            spotter->onResult(result);
+                        timeline->apply(result);
+                        if (cache && result.is_final())
+                            results.emplace_back(result);
+                        transcript.add(result);
+                    };
+                    std::unique_ptr<RecognitionSession> session;
+                    std::unique_ptr<SpeculativeRecognition> speculation;
+                    auto outcome = ConcurrencyLimiter::Outcome::Success;
+                    try {
+                        INFO("Recognizing '{}'", path);
+                        auto requests = client->prepareAudio(audio);
+                        if (candidates.size() > 1) {
+                            speculation = std::make_unique<SpeculativeRecognition>(
+                                    *client, candidates, std::chrono::milliseconds(configuration.getWarmUp()));
+                            speculation->run(std::move(requests), keepFinal);
+                        } else {
+                            session = client->createSession(std::move(requests), keepFinal);
+                            session->run();
+                        }
+                        // Only reached when the session ended OK. Without a final result it may still have been a
+                        // transient failure, e.g. hedged streams that all closed early, which is not worth replaying.
+                        if (cache && !results.empty()) {
+                            std::lock_guard<std::mutex> lock(cacheMutex);
+                            cache->store(key, results);
+                        } else if (cache)
+                            WARN("'{}' gave no final result, not cached", path);
+                        writeTranscript(configuration, path, transcriptNames, transcript);
+                    } catch (std::exception &e) {
+                        ERROR("'{}': {}", path, e.what());
+                        ++failures;
+                        outcome = ConcurrencyLimiter::Outcome::Failure;
+                    }
+                    const RecognitionSession *finished = speculation ? speculation->getSession() : session.get();
+                    if (outcome == ConcurrencyLimiter::Outcome::Failure && finished &&
+                        isPushback(finished->getStatusCode()))
+                        outcome = ConcurrencyLimiter::Outcome::Overload;
+                    limiter.release(ticket, outcome,
+                                    finished ? finished->getFinalLatency() : std::chrono::microseconds(0));
+                }));
+            } catch (std::exception &e) {
+                ERROR("'{}': {}", path, e.what());
+                ++failures;
+            }
+        }
+        for (auto &session: sessions)
+            session.wait();
+        if (predicted.count() > 0)
+            INFO("Recognized {} files in {:.1f} s, predicted {:.1f} s.", paths.size(),
+                 toSeconds(std::chrono::duration_cast<std::chrono::microseconds>(
+                         std::chrono::steady_clock::now() - start)), toSeconds(predicted));
+        return failures > 0 ? -1 : 0;
+    }
+
+}
+
 int main(int argc, char *argv[]) {
     try {
         Configuration configuration(argc, argv);
-        RecognitionClient client(configuration);
-        client.performStreamingRecognition();
+        if (!configuration.getRtpPorts().empty())
+            return ingestRtp(configuration);
+        return recognizeFiles(configuration);
     } catch (std::exception &e) {
         ERROR(e.what());
         return -1;
     }
     return 0;
-}
\ No newline at end of file
+}
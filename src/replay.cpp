@@ -0,0 +1,130 @@
+#include "SessionCapture.h"
+#include "StandInServer.h"
+#include "logger.h"
+
+#include "recognition.grpc.pb.h"
+
+#include <cxxopts.hpp>
+#include <grpcpp/create_channel.h>
+#include <grpcpp/security/credentials.h>
+
+#include <algorithm>
+#include <thread>
+
+using namespace speechcenter::recognizer::v1;
+
+namespace {
+
+    struct ReplayReport {
+        std::chrono::microseconds wallTime{0};
+        std::size_t responses{0};
+        std::vector<double> lagsMs;
+    };
+
+    /*
+     * Plays the captured requests against a recognizer, keeping their recorded offsets scaled by timeScale,
+     * and measures how late each response arrives compared to the capture.
+     */
+    ReplayReport play(const SessionCapture &capture, const std::string &target, double timeScale) {
+        auto stub = Recognizer::NewStub(grpc::CreateChannel(target, grpc::InsecureChannelCredentials()));
+        grpc::ClientContext context;
+        auto stream = stub->StreamingRecognize(&context);
+        const auto start = std::chrono::steady_clock::now();
+        auto elapsed = [&start] {
+            return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        };
+
+        std::vector<std::chrono::microseconds> expected;
+        for (const auto &record: capture.getRecords())
+            if (record.has_response())
+                expected.emplace_back(std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::microseconds(record.timestamp_us()) * timeScale));
+
+        std::thread writer([&] {
+            for (const auto &record: capture.getRecords()) {
+                if (!record.has_request())
+                    continue;
+                std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::microseconds(record.timestamp_us()) * timeScale));
+                if (!stream->Write(record.request()))
+                    return;
+            }
+            stream->WritesDone();
+        });
+
+        ReplayReport report;
+        RecognitionStreamingResponse response;
+        while (stream->Read(&response)) {
+            if (report.responses < expected.size())
+                report.lagsMs.emplace_back((elapsed() - expected[report.responses]).count() / 1000.0);
+            ++report.responses;
+        }
+        writer.join();
+        auto status = stream->Finish();
+        if (!status.ok())
+            ERROR("Replay stream finished with error: {}", status.error_message());
+        report.wallTime = elapsed();
+        return report;
+    }
+
+    double percentile(std::vector<double> values, double fraction) {
+        if (values.empty())
+            return 0;
+        auto position = values.begin() + static_cast<long>(fraction * (values.size() - 1));
+        std::nth_element(values.begin(), position, values.end());
+        return *position;
+    }
+
+}
+
+int main(int argc, char *argv[]) {
+    try {
+        std::string capturePath, target, listen;
+        double timeScale;
+        bool serveOnly;
+
+        cxxopts::Options options(argv[0], "Verbio Technlogies S.L. - Speech Center session replay");
+        options.set_width(180).add_options()
+                ("c,capture", "Capture file recorded with cli_client --capture.", cxxopts::value(capturePath), "file")
+                ("listen", "Address of the local stand-in server.",
+                 cxxopts::value(listen)->default_value("localhost:0"), "address")
+                ("target", "Replay against this insecure host instead of the local stand-in server.",
+                 cxxopts::value(target), "host")
+                ("x,time-scale", "Multiplier applied to every recorded offset. 0 replays as fast as possible.",
+                 cxxopts::value(timeScale)->default_value("1.0"))
+                ("serve-only", "Only run the stand-in server, e.g. to point different cli_client builds at it.",
+                 cxxopts::value(serveOnly)->default_value("false"))
+                ("h,help", "this help message");
+        auto parsedOptions = options.parse(argc, argv);
+        if (parsedOptions.count("h") > 0 || capturePath.empty()) {
+            std::cout << options.help();
+            return 0;
+        }
+        if (timeScale < 0)
+            throw std::runtime_error("Time scale cannot be negative.");
+
+        SessionCapture capture(capturePath);
+        INFO("Loaded {} requests and {} responses spanning {} ms.", capture.countRequests(), capture.countResponses(),
+             capture.getDuration().count() / 1000);
+
+        StandInServer server(capture, timeScale);
+        if (target.empty()) {
+            int port = server.start(listen);
+            if (serveOnly) {
+                server.wait();
+                return 0;
+            }
+            target = "localhost:" + std::to_string(port);
+        }
+
+        auto report = play(capture, target, timeScale);
+        INFO("Replayed {} of {} responses in {} ms.", report.responses, capture.countResponses(),
+             report.wallTime.count() / 1000);
+        INFO("Response lag against capture: p50 {:.1f} ms, p95 {:.1f} ms, max {:.1f} ms.",
+             percentile(report.lagsMs, 0.5), percentile(report.lagsMs, 0.95), percentile(report.lagsMs, 1.0));
+    } catch (std::exception &e) {
+        ERROR(e.what());
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include "Audio.h"
+#include "G711.h"
+#include "RtpPacket.h"
+#include "logger.h"
+
+#include <cxxopts.hpp>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <random>
+#include <thread>
+
+namespace {
+
+    struct SenderSettings {
+        sockaddr_in target{};
+        uint8_t payloadType{RtpPacket::payloadTypePcmu};
+        std::size_t samplesPerPacket{160};
+        double loss{0};
+        double reorder{0};
+    };
+
+    std::vector<RtpPacket> packetize(const Audio &audio, const SenderSettings &settings, uint32_t ssrc,
+                                     std::vector<uint8_t> &codes) {
+        codes.resize(audio.getLengthInFrames());
+        for (std::size_t i = 0; i < codes.size(); ++i)
+            codes[i] = settings.payloadType == RtpPacket::payloadTypePcmu ? g711::encodeUlaw(audio.getData()[i])
+                                                                          : g711::encodeAlaw(audio.getData()[i]);
+        std::vector<RtpPacket> packets;
+        for (std::size_t offset = 0; offset < codes.size(); offset += settings.samplesPerPacket) {
+            RtpPacket packet;
+            packet.payloadType = settings.payloadType;
+            packet.marker = offset == 0;
+            packet.sequence = static_cast<uint16_t>(packets.size());
+            packet.timestamp = static_cast<uint32_t>(offset);
+            packet.ssrc = ssrc;
+            packet.payload = codes.data() + offset;
+            packet.payloadSize = std::min(settings.samplesPerPacket, codes.size() - offset);
+            packets.emplace_back(packet);
+        }
+        return packets;
+    }
+
+    // Sends one flow in real time from its own socket, dropping and swapping packets as asked.
+    void sendFlow(const Audio &audio, const SenderSettings &settings, uint32_t seed) {
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<double> draw(0, 1);
+        std::vector<uint8_t> codes;
+        auto packets = packetize(audio, settings, static_cast<uint32_t>(random()), codes);
+        for (std::size_t i = 0; i + 1 < packets.size(); ++i)
+            if (draw(random) < settings.reorder) {
+                std::swap(packets[i], packets[i + 1]);
+                ++i;
+            }
+
+        int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd < 0) {
+            ERROR("Unable to create UDP socket");
+            return;
+        }
+        const auto interval = std::chrono::microseconds(settings.samplesPerPacket * 1000000 / g711::sampleRate);
+        auto next = std::chrono::steady_clock::now();
+        std::size_t dropped = 0;
+        for (const auto &packet: packets) {
+            std::this_thread::sleep_until(next);
+            next += interval;
+            if (draw(random) < settings.loss) {
+                ++dropped;
+                continue;
+            }
+            auto datagram = packet.serialize();
+            sendto(fd, datagram.data(), datagram.size(), 0, reinterpret_cast<const sockaddr *>(&settings.target),
+                   sizeof(settings.target));
+        }
+        close(fd);
+        INFO("Flow {:08x} sent {} packets, dropped {}.", packets.empty() ? 0 : packets.front().ssrc,
+             packets.size() - dropped, dropped);
+    }
+
+}
+
+int main(int argc, char *argv[]) {
+    try {
+        std::string audioPath, target, codec;
+        uint32_t flows, packetTime, seed;
+        SenderSettings settings;
+
+        cxxopts::Options options(argv[0], "Verbio Technlogies S.L. - G.711 RTP test sender for cli_client --rtp-ports");
+        options.set_width(180).add_options()
+                ("a,audio", "8 kHz audio to send.", cxxopts::value(audioPath), "file")
+                ("target", "IPv4 address and port to send to.",
+                 cxxopts::value(target)->default_value("127.0.0.1:40000"), "address")
+                ("codec", "PCMU or PCMA.", cxxopts::value(codec)->default_value("PCMU"))
+                ("flows", "Number of concurrent flows, each from its own source port and SSRC.",
+                 cxxopts::value(flows)->default_value("1"))
+                ("ptime", "Milliseconds of audio per packet.", cxxopts::value(packetTime)->default_value("20"))
+                ("loss", "Fraction of packets dropped.", cxxopts::value(settings.loss)->default_value("0"))
+                ("reorder", "Fraction of packets swapped with the next one.",
+                 cxxopts::value(settings.reorder)->default_value("0"))
+                ("seed", "Seed of the loss and reorder draws.", cxxopts::value(seed)->default_value("1"))
+                ("h,help", "this help message");
+        auto parsedOptions = options.parse(argc, argv);
+        if (parsedOptions.count("h") > 0 || audioPath.empty()) {
+            std::cout << options.help();
+            return 0;
+        }
+
+        auto colon = target.rfind(':');
+        settings.target.sin_family = AF_INET;
+        if (colon == std::string::npos || inet_pton(AF_INET, target.substr(0, colon).c_str(),
+                                                    &settings.target.sin_addr) != 1)
+            throw std::runtime_error("Invalid target '" + target + "', expected address:port.");
+        settings.target.sin_port = htons(static_cast<uint16_t>(std::stoul(target.substr(colon + 1))));
+        if (codec == "PCMA")
+            settings.payloadType = RtpPacket::payloadTypePcma;
+        else if (codec != "PCMU")
+            throw std::runtime_error("Unsupported codec '" + codec + "'.");
+        settings.samplesPerPacket = g711::sampleRate * packetTime / 1000;
+        if (settings.samplesPerPacket == 0)
+            throw std::runtime_error("Packet time must be at least 1 ms.");
+
+        Audio audio(audioPath);
+        if (audio.getSamplingRate() != g711::sampleRate)
+            throw std::runtime_error("G.711 needs 8 kHz audio.");
+
+        std::vector<std::thread> senders;
+        for (uint32_t flow = 0; flow < flows; ++flow)
+            senders.emplace_back(sendFlow, std::cref(audio), std::cref(settings), seed + flow);
+        for (auto &sender: senders)
+            sender.join();
+    } catch (std::exception &e) {
+        ERROR(e.what());
+        return -1;
+    }
+    return 0;
+}
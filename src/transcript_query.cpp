@@ -0,0 +1,57 @@
+#include "TranscriptStore.h"
+#include "logger.h"
+
+#include <cxxopts.hpp>
+
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+    void print(const std::string &path, const std::vector<transcript::Word> &words) {
+        for (const auto &word: words)
+            std::cout << path << '\t' << std::fixed << std::setprecision(3) << word.startTime << '\t' << word.endTime
+                      << '\t' << word.speaker << '\t' << std::setprecision(2) << word.confidence << '\t' << word.text
+                      << '\n';
+    }
+
+}
+
+int main(int argc, char *argv[]) {
+    try {
+        std::string range, term;
+        std::vector<std::string> paths;
+
+        cxxopts::Options options(argv[0], "Verbio Technlogies S.L. - Query transcripts written by cli_client --transcript-dir");
+        options.set_width(180).add_options()
+                ("between", "Words spoken between two times in seconds, e.g. 12.5,20", cxxopts::value(range), "from,to")
+                ("term", "Every occurrence of the word.", cxxopts::value(term), "word")
+                ("transcripts", "Transcript files to query.", cxxopts::value(paths))
+                ("h,help", "this help message");
+        options.parse_positional({"transcripts"});
+        options.positional_help("transcript.sct...");
+        auto parsedOptions = options.parse(argc, argv);
+        if (parsedOptions.count("h") > 0 || paths.empty() || range.empty() == term.empty()) {
+            std::cout << options.help();
+            return 0;
+        }
+
+        double from = 0, to = 0;
+        if (!range.empty()) {
+            const auto comma = range.find(',');
+            if (comma == std::string::npos)
+                throw std::runtime_error("Invalid range '" + range + "', expected from,to.");
+            from = std::stod(range.substr(0, comma));
+            to = std::stod(range.substr(comma + 1));
+        }
+        std::cout << "file\tstart\tend\tspeaker\tconfidence\tword\n";
+        for (const auto &path: paths) {
+            TranscriptReader reader(path);
+            print(path, range.empty() ? reader.find(term) : reader.between(from, to));
+        }
+    } catch (std::exception &e) {
+        ERROR(e.what());
+        return -1;
+    }
+    return 0;
+}
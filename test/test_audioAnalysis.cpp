@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include "AudioAnalysis.h"
+
+#include <cmath>
+#include <sstream>
+
+namespace {
+
+    // White noise, which fills the whole band, at about the level of speech.
+    std::vector<int16_t> noise(std::size_t length, int amplitude = 3000, int offset = 0) {
+        std::vector<int16_t> samples(length);
+        uint32_t state = 7;
+        for (auto &sample: samples) {
+            state = state * 1664525 + 1013904223;
+            auto uniform = static_cast<int>((state >> 16) * (2 * amplitude + 1) >> 16);
+            sample = static_cast<int16_t>(offset + uniform - amplitude);
+        }
+        return samples;
+    }
+
+    // Tones up to 3.4 kHz, like narrowband speech upsampled to 16 kHz.
+    std::vector<int16_t> narrowband(std::size_t length) {
+        std::vector<int16_t> samples(length);
+        for (std::size_t i = 0; i < length; ++i) {
+            double t = static_cast<double>(i) / 16000;
+            samples[i] = static_cast<int16_t>(std::lround(
+                    2000 * std::sin(2 * M_PI * 300 * t) + 1500 * std::sin(2 * M_PI * 1100 * t) +
+                    800 * std::sin(2 * M_PI * 2500 * t) + 400 * std::sin(2 * M_PI * 3400 * t)));
+        }
+        return samples;
+    }
+
+    AudioReport analyze(const std::vector<int16_t> &samples, int64_t sampleRate, int64_t declaredFrames = 0) {
+        AudioAnalyzer analyzer(sampleRate);
+        analyzer.add(samples.data(), samples.size());
+        return analyzer.finish(declaredFrames);
+    }
+
+}
+
+TEST(AudioAnalysis, speechLikeAudioHasNoProblems) {
+    auto report = analyze(noise(16000 * 5), 16000);
+    EXPECT_NEAR(report.rms, 20 * std::log10(3000 / std::sqrt(3.0) / 32768), 0.2);
+    EXPECT_NEAR(report.peak, 20 * std::log10(3000.0 / 32768), 0.1);
+    EXPECT_NEAR(report.dcOffset, 0, 0.001);
+    EXPECT_EQ(report.silence, 0);
+    EXPECT_EQ(report.bandwidth, 8000);
+    EXPECT_GT(report.highBand, -10);
+    EXPECT_TRUE(report.findProblems(16000).empty());
+}
+
+TEST(AudioAnalysis, findsUpsampledNarrowbandAudio) {
+    auto report = analyze(narrowband(16000 * 5), 16000);
+    EXPECT_LT(report.highBand, -60);
+    EXPECT_EQ(report.bandwidth, 4000);
+    ASSERT_EQ(report.findProblems(16000).size(), 1);
+    EXPECT_NE(report.findProblems(16000)[0].find("upsampled"), std::string::npos);
+
+    // At 8 kHz the same content fills the band.
+    EXPECT_TRUE(analyze(narrowband(8000 * 5), 8000).findProblems(8000).empty());
+}
+
+TEST(AudioAnalysis, findsSilence) {
+    auto samples = noise(8000 * 10, 20);
+    auto report = analyze(samples, 8000);
+    EXPECT_EQ(report.silence, 1);
+    EXPECT_EQ(report.findProblems(8000), std::vector<std::string>{"silent"});
+
+    // One second of speech in ten.
+    auto speech = noise(8000);
+    std::copy(speech.begin(), speech.end(), samples.begin() + 8000 * 4);
+    EXPECT_NEAR(analyze(samples, 8000).silence, 0.9, 0.001);
+    EXPECT_TRUE(analyze(samples, 8000).findProblems(8000).empty());
+    EXPECT_EQ(analyze({}, 8000).findProblems(8000), std::vector<std::string>{"no audio"});
+}
+
+TEST(AudioAnalysis, findsClippingAndDcOffset) {
+    auto clipped = noise(8000 * 2, 30000);
+    for (std::size_t i = 0; i < clipped.size(); i += 100)
+        clipped[i] = i % 200 ? 32767 : -32768;
+    auto report = analyze(clipped, 8000);
+    EXPECT_NEAR(report.clipping, 0.01, 0.001);
+    EXPECT_DOUBLE_EQ(report.peak, 0);
+    ASSERT_EQ(report.findProblems(8000).size(), 1);
+    EXPECT_EQ(report.findProblems(8000)[0], "clipped, 1% of the samples at full scale");
+
+    auto offset = analyze(noise(8000 * 2, 3000, 1638), 8000);
+    EXPECT_NEAR(offset.dcOffset, 0.05, 0.001);
+    ASSERT_EQ(offset.findProblems(8000).size(), 1);
+    EXPECT_EQ(offset.findProblems(8000)[0].rfind("DC offset of 5", 0), 0);
+}
+
+TEST(AudioAnalysis, findsTruncationAndRateMismatch) {
+    auto report = analyze(noise(8000), 8000, 16000);
+    std::vector<std::string> expected{"truncated, 8000 of 16000 frames decoded",
+                                      "sampled at 8000 Hz but streamed as 16000 Hz"};
+    EXPECT_EQ(report.findProblems(16000), expected);
+}
+
+TEST(AudioAnalysis, findsInterleavedChannels) {
+    AudioAnalyzer analyzer(8000, 2);
+    auto samples = noise(8000 * 2);
+    analyzer.add(samples.data(), samples.size());
+    EXPECT_EQ(analyzer.finish(0).findProblems(8000),
+              std::vector<std::string>{"2 channels interleaved but streamed as mono"});
+}
+
+TEST(AudioAnalysis, blocksOfAnySizeGiveTheSameReport) {
+    auto samples = noise(16000 * 3);
+    std::copy_n(narrowband(16000).begin(), 16000, samples.begin());
+    auto whole = analyze(samples, 16000);
+    AudioAnalyzer analyzer(16000);
+    for (std::size_t offset = 0, block = 1; offset < samples.size(); offset += block, block = block * 7 % 9973)
+        analyzer.add(samples.data() + offset, std::min(block, samples.size() - offset));
+    auto blocks = analyzer.finish(0);
+    EXPECT_DOUBLE_EQ(blocks.rms, whole.rms);
+    EXPECT_DOUBLE_EQ(blocks.silence, whole.silence);
+    EXPECT_NEAR(blocks.highBand, whole.highBand, 1e-4);
+}
+
+TEST(AudioAnalysis, writesOneTsvLinePerFile) {
+    std::ostringstream out;
+    AudioReport::writeTsvHeader(out);
+    auto report = analyze(noise(8000, 20), 8000);
+    report.writeTsv(out, "quiet.wav", report.findProblems(8000));
+    std::string header, line;
+    std::istringstream in(out.str());
+    std::getline(in, header);
+    std::getline(in, line);
+    EXPECT_EQ(std::count(header.begin(), header.end(), '\t'), std::count(line.begin(), line.end(), '\t'));
+    EXPECT_EQ(line.substr(0, 12), "quiet.wav\t1\t");
+    EXPECT_EQ(line.substr(line.rfind('\t') + 1), "silent");
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include "AudioPrefetcher.h"
+#include "gRpcExceptions.h"
+
+#include "sndfile.hh"
+
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+    std::vector<int16_t> tone(std::size_t length, int samplingRate) {
+        std::vector<int16_t> samples(length);
+        for (std::size_t i = 0; i < length; ++i)
+            samples[i] = static_cast<int16_t>(std::lround(8000 * std::sin(2 * M_PI * 440 * i / samplingRate)));
+        return samples;
+    }
+
+    // Encodes a small fixture with libsndfile, the same library that decodes it.
+    void writeFixture(const std::string &path, int format, int samplingRate, const std::vector<int16_t> &samples,
+                      int channels = 1) {
+        SndfileHandle file(path, SFM_WRITE, format, channels, samplingRate);
+        ASSERT_EQ(file.error(), 0) << file.strError();
+        ASSERT_EQ(file.write(samples.data(), static_cast<sf_count_t>(samples.size())),
+                  static_cast<sf_count_t>(samples.size()));
+    }
+
+}
+
+TEST(AudioPrefetcher, decodesFlacLosslessly) {
+    const std::string path = "test_fixture.flac";
+    const auto samples = tone(16000 * 3 / 2, 16000);
+    writeFixture(path, SF_FORMAT_FLAC | SF_FORMAT_PCM_16, 16000, samples);
+    Audio audio(path);
+    std::remove(path.c_str());
+    EXPECT_EQ(audio.getSamplingRate(), 16000);
+    ASSERT_EQ(audio.getLengthInFrames(), samples.size());
+    EXPECT_TRUE(std::equal(samples.begin(), samples.end(), audio.getData()));
+}
+
+TEST(AudioPrefetcher, decodesOggOpus) {
+    const std::string path = "test_fixture.opus";
+    const auto samples = tone(8000 * 2, 8000);
+    writeFixture(path, SF_FORMAT_OGG | SF_FORMAT_OPUS, 8000, samples);
+    Audio audio(path);
+    std::remove(path.c_str());
+    EXPECT_EQ(audio.getSamplingRate(), 8000);
+    // The granule position of the last page trims the padding of the last 20 ms Opus frame.
+    EXPECT_NEAR(audio.getLengthInFrames(), samples.size(), 8000 / 50);
+}
+
+TEST(AudioPrefetcher, decodesFilesInOrder) {
+    const std::vector<std::string> paths{"test_fixture-1.flac", "test_fixture-2.opus", "test_fixture-3.flac"};
+    writeFixture(paths[0], SF_FORMAT_FLAC | SF_FORMAT_PCM_16, 8000, tone(800, 8000));
+    writeFixture(paths[1], SF_FORMAT_OGG | SF_FORMAT_OPUS, 16000, tone(16000, 16000));
+    writeFixture(paths[2], SF_FORMAT_FLAC | SF_FORMAT_PCM_16, 16000, tone(1600, 16000));
+    AudioPrefetcher prefetcher(paths, 2);
+    std::vector<int64_t> rates;
+    while (prefetcher.hasNext())
+        rates.emplace_back(prefetcher.next()->getSamplingRate());
+    for (const auto &path: paths)
+        std::remove(path.c_str());
+    EXPECT_EQ(rates, (std::vector<int64_t>{8000, 16000, 16000}));
+}
+
+TEST(AudioPrefetcher, analyzesOnlyWhenAsked) {
+    const std::string path = "test_fixture-stereo.flac";
+    writeFixture(path, SF_FORMAT_FLAC | SF_FORMAT_PCM_16, 8000, tone(1600, 8000), 2);
+    auto plain = AudioPrefetcher({path}, 1).next();
+    auto analyzed = AudioPrefetcher({path}, 1, true).next();
+    std::remove(path.c_str());
+    EXPECT_EQ(plain->getReport().frames, 0);
+    EXPECT_EQ(analyzed->getReport().frames, 1600);
+    EXPECT_EQ(analyzed->getReport().findProblems(8000),
+              std::vector<std::string>{"2 channels interleaved but streamed as mono"});
+}
+
+TEST(AudioPrefetcher, decodeErrorsAreRaisedForTheirOwnFile) {
+    AudioPrefetcher prefetcher({"missing-1.wav", "missing-2.flac", "missing-3.opus"}, 1);
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(prefetcher.hasNext());
+        EXPECT_THROW(prefetcher.next(), IOError);
+    }
+    EXPECT_FALSE(prefetcher.hasNext());
+    EXPECT_THROW(prefetcher.next(), IOError);
+}
+
+TEST(AudioPrefetcher, stopsWithFilesPending) {
+    AudioPrefetcher prefetcher({"missing-1.wav", "missing-2.wav", "missing-3.wav", "missing-4.wav"}, 2);
+    EXPECT_THROW(prefetcher.next(), IOError);
+}
@@ -2,9 +2,43 @@
 #include <gtest/gtest.h>
 
 #include "Configuration.h"
+#include "gRpcExceptions.h"
 
 
 TEST(CommandLine, happy_path) {
     int argc = 8;
     const char* argv[] = {"cli_client", "-a", "file.wav", "-b", "file.bnf", "-l pt-BR", "-t", "file.token", "-T", "GENERIC"};
-}
\ No newline at end of file
+}
+namespace {
+
+    Configuration parseWithHosts(const char *hosts) {
+        const char *argv[] = {"cli_client", "-a", "file.wav", "-T", "GENERIC", "-A", "V2", "-H", hosts};
+        return {sizeof(argv) / sizeof(argv[0]), const_cast<char **>(argv)};
+    }
+
+}
+
+TEST(CommandLine, commaSeparatedHostsAreSplit) {
+    auto configuration = parseWithHosts("eu.speechcenter.verbio.com,,us.speechcenter.verbio.com:443");
+    std::vector<std::string> expected{"eu.speechcenter.verbio.com", "us.speechcenter.verbio.com:443"};
+    EXPECT_EQ(configuration.getHosts(), expected);
+    EXPECT_EQ(configuration.getHost(), "eu.speechcenter.verbio.com");
+}
+
+TEST(CommandLine, singleHostIsTheOnlyEndpoint) {
+    auto configuration = parseWithHosts("localhost:50051");
+    EXPECT_EQ(configuration.getHosts(), std::vector<std::string>{"localhost:50051"});
+    EXPECT_EQ(configuration.getHost(), "localhost:50051");
+}
+
+TEST(CommandLine, emptyHostListIsRejected) {
+    EXPECT_THROW(parseWithHosts(","), GrpcException);
+}
+
+TEST(CommandLine, audioPathsAreKeptWhole) {
+    const char *argv[] = {"cli_client", "-a", "calls/2024,q1.wav", "-a", "b.wav", "-T", "GENERIC", "-A", "V2"};
+    Configuration configuration(sizeof(argv) / sizeof(argv[0]), const_cast<char **>(argv));
+    std::vector<std::string> expected{"calls/2024,q1.wav", "b.wav"};
+    EXPECT_EQ(configuration.getAudioPaths(), expected);
+    EXPECT_EQ(configuration.getAudioPath(), "calls/2024,q1.wav");
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include "ConcurrencyLimiter.h"
+
+#include <future>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+    typedef ConcurrencyLimiter::Outcome Outcome;
+
+    // Runs rounds of as many sessions as the limit allows, all finishing with the given latency.
+    void runRounds(ConcurrencyLimiter &limiter, int rounds, std::chrono::microseconds latency) {
+        for (int round = 0; round < rounds; ++round) {
+            std::vector<ConcurrencyLimiter::Ticket> tickets;
+            for (auto i = static_cast<std::size_t>(limiter.getLimit()); i > 0; --i)
+                tickets.emplace_back(limiter.acquire());
+            for (const auto &ticket: tickets)
+                limiter.release(ticket, Outcome::Success, latency);
+        }
+    }
+
+}
+
+TEST(ConcurrencyLimiter, growsWhileLatencyIsFlat) {
+    ConcurrencyLimiter limiter(8);
+    EXPECT_EQ(limiter.getLimit(), 1);
+    runRounds(limiter, 3, 200ms);
+    EXPECT_GE(limiter.getLimit(), 3);
+    runRounds(limiter, 20, 200ms);
+    EXPECT_EQ(limiter.getLimit(), 8);
+}
+
+TEST(ConcurrencyLimiter, backsOffOncePerOverloadEvent) {
+    ConcurrencyLimiter limiter(8);
+    runRounds(limiter, 20, 200ms);
+    ASSERT_EQ(limiter.getLimit(), 8);
+    std::vector<ConcurrencyLimiter::Ticket> tickets;
+    for (int i = 0; i < 8; ++i)
+        tickets.emplace_back(limiter.acquire());
+    for (const auto &ticket: tickets)
+        limiter.release(ticket, Outcome::Overload, 0us);
+    EXPECT_EQ(limiter.getLimit(), 4);
+    limiter.release(limiter.acquire(), Outcome::Overload, 0us);
+    EXPECT_EQ(limiter.getLimit(), 2);
+}
+
+TEST(ConcurrencyLimiter, shrinksWhenLatencyRises) {
+    ConcurrencyLimiter limiter(8);
+    runRounds(limiter, 20, 200ms);
+    runRounds(limiter, 1, 2s);
+    EXPECT_LT(limiter.getLimit(), 8);
+    limiter.release(limiter.acquire(), Outcome::Failure, 0us);
+    EXPECT_LT(limiter.getLimit(), 8);
+}
+
+TEST(ConcurrencyLimiter, acquireWaitsForTheLimit) {
+    std::vector<double> limits;
+    ConcurrencyLimiter limiter(4, [&limits](double limit, std::size_t) { limits.emplace_back(limit); });
+    auto first = limiter.acquire();
+    auto second = std::async(std::launch::async, [&limiter] { return limiter.acquire(); });
+    EXPECT_EQ(second.wait_for(50ms), std::future_status::timeout);
+    limiter.release(first, Outcome::Success, 100ms);
+    EXPECT_EQ(second.wait_for(1s), std::future_status::ready);
+    EXPECT_EQ(limiter.getInFlight(), 1);
+    EXPECT_EQ(limits, (std::vector<double>{1, 2, 2}));
+}
+
+TEST(ConcurrencyLimiter, listenerSeesEverySessionInOrder) {
+    std::vector<std::size_t> inFlight;
+    ConcurrencyLimiter limiter(8, [&inFlight](double, std::size_t sessions) { inFlight.emplace_back(sessions); });
+    runRounds(limiter, 20, 200ms);
+    inFlight.clear();
+    std::vector<std::future<void>> sessions;
+    for (int i = 0; i < 64; ++i)
+        sessions.emplace_back(std::async(std::launch::async, [&limiter] {
+            limiter.release(limiter.acquire(), Outcome::Success, 200ms);
+        }));
+    for (auto &session: sessions)
+        session.get();
+    // In order, every call moves the gauge by exactly one session and the last one leaves it at zero.
+    ASSERT_EQ(inFlight.size(), 128);
+    std::size_t previous = 0;
+    for (auto sessions: inFlight) {
+        EXPECT_EQ(sessions > previous ? sessions - previous : previous - sessions, 1);
+        previous = sessions;
+    }
+    EXPECT_EQ(inFlight.back(), 0);
+}
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include "EndpointPool.h"
+#include "recognition.grpc.pb.h"
+
+#include <grpcpp/create_channel.h>
+#include <grpcpp/security/credentials.h>
+#include <grpcpp/security/server_credentials.h>
+#include <grpcpp/server_builder.h>
+
+#include <thread>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+    // A server that accepts connections, which is all a probe needs.
+    struct LocalServer {
+        LocalServer() {
+            grpc::ServerBuilder builder;
+            builder.AddListeningPort("localhost:0", grpc::InsecureServerCredentials(), &port);
+            builder.RegisterService(&service);
+            server = builder.BuildAndStart();
+        }
+
+        ~LocalServer() {
+            server->Shutdown();
+        }
+
+        std::string getHost() const {
+            return "localhost:" + std::to_string(port);
+        }
+
+        speechcenter::recognizer::v1::Recognizer::Service service;
+        int port{0};
+        std::unique_ptr<grpc::Server> server;
+    };
+
+    std::shared_ptr<grpc::Channel> createChannel(const std::string &host, bool probe) {
+        grpc::ChannelArguments arguments;
+        if (probe)
+            arguments.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+        return grpc::CreateCustomChannel(host, grpc::InsecureChannelCredentials(), arguments);
+    }
+
+    std::vector<std::string> hostsOf(const std::vector<std::shared_ptr<Endpoint>> &ranked) {
+        std::vector<std::string> hosts;
+        for (const auto &endpoint: ranked)
+            hosts.emplace_back(endpoint->host);
+        return hosts;
+    }
+
+}
+
+TEST(EndpointPool, singleHostIsNotProbed) {
+    int probes = 0;
+    EndpointPool pool({"localhost:1"}, [&probes](const std::string &host, bool probe) {
+        probes += probe;
+        return createChannel(host, probe);
+    }, 10ms);
+    std::this_thread::sleep_for(50ms);
+    EXPECT_EQ(probes, 0);
+    ASSERT_EQ(pool.rank().size(), 1);
+    EXPECT_TRUE(pool.rank().front()->healthy);
+}
+
+TEST(EndpointPool, unreachableHostRanksLast) {
+    LocalServer server;
+    EndpointPool pool({"localhost:1", server.getHost()}, createChannel, 0ms);
+    auto ranked = pool.rank();
+    EXPECT_EQ(hostsOf(ranked), (std::vector<std::string>{server.getHost(), "localhost:1"}));
+    EXPECT_TRUE(ranked[0]->measured);
+    EXPECT_FALSE(ranked[1]->healthy);
+}
+
+TEST(EndpointPool, failsOverUntilAvailableAgain) {
+    LocalServer first, second;
+    EndpointPool pool({first.getHost(), second.getHost()}, createChannel, 0ms);
+    auto ranked = pool.rank();
+    ASSERT_TRUE(ranked[0]->healthy && ranked[1]->healthy);
+    pool.reportUnavailable(ranked[0]);
+    EXPECT_EQ(hostsOf(pool.rank()), (std::vector<std::string>{ranked[1]->host, ranked[0]->host}));
+    pool.reportUnavailable(ranked[1]);
+    EXPECT_EQ(pool.rank().size(), 2);
+    pool.reportAvailable(ranked[0]);
+    EXPECT_EQ(hostsOf(pool.rank()), hostsOf(ranked));
+}
+
+TEST(EndpointPool, unavailableHostIsRetriedWithoutProbes) {
+    LocalServer first, second;
+    EndpointPool pool({first.getHost(), second.getHost()}, createChannel, 0ms, 100ms);
+    auto ranked = pool.rank();
+    pool.reportUnavailable(ranked[0]);
+    EXPECT_FALSE(pool.rank().back()->healthy);
+    std::this_thread::sleep_for(150ms);
+    EXPECT_EQ(hostsOf(pool.rank()), hostsOf(ranked));
+    EXPECT_TRUE(ranked[0]->healthy);
+}
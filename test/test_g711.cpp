@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include "G711.h"
+
+#include <cstdlib>
+
+namespace {
+
+    // Straightforward decoders from the ITU-T G.711 reference implementation.
+    int referenceUlaw(uint8_t code) {
+        code = ~code;
+        int magnitude = ((code & 0x0F) << 3) + 0x84;
+        magnitude <<= (code & 0x70) >> 4;
+        return (code & 0x80) ? 0x84 - magnitude : magnitude - 0x84;
+    }
+
+    int referenceAlaw(uint8_t code) {
+        code ^= 0x55;
+        int magnitude = (code & 0x0F) << 4;
+        int segment = (code & 0x70) >> 4;
+        switch (segment) {
+            case 0:
+                magnitude += 8;
+                break;
+            case 1:
+                magnitude += 0x108;
+                break;
+            default:
+                magnitude += 0x108;
+                magnitude <<= segment - 1;
+        }
+        return (code & 0x80) ? magnitude : -magnitude;
+    }
+
+    std::vector<uint8_t> allCodes() {
+        std::vector<uint8_t> codes;
+        for (int code = 0; code < 256; ++code)
+            codes.emplace_back(static_cast<uint8_t>(code));
+        return codes;
+    }
+
+}
+
+TEST(G711, ulawDecoderMatchesReference) {
+    auto codes = allCodes();
+    std::vector<int16_t> samples(codes.size());
+    g711::decodeUlaw(codes.data(), samples.data(), codes.size());
+    for (std::size_t i = 0; i < codes.size(); ++i)
+        EXPECT_EQ(samples[i], referenceUlaw(codes[i])) << "code " << i;
+}
+
+TEST(G711, alawDecoderMatchesReference) {
+    auto codes = allCodes();
+    std::vector<int16_t> samples(codes.size());
+    g711::decodeAlaw(codes.data(), samples.data(), codes.size());
+    for (std::size_t i = 0; i < codes.size(); ++i)
+        EXPECT_EQ(samples[i], referenceAlaw(codes[i])) << "code " << i;
+}
+
+TEST(G711, encodersRoundTripWithinQuantization) {
+    for (int sample = -32768; sample < 32768; sample += 7) {
+        uint8_t ulaw = g711::encodeUlaw(static_cast<int16_t>(sample));
+        uint8_t alaw = g711::encodeAlaw(static_cast<int16_t>(sample));
+        int16_t decodedUlaw, decodedAlaw;
+        g711::decodeUlaw(&ulaw, &decodedUlaw, 1);
+        g711::decodeAlaw(&alaw, &decodedAlaw, 1);
+        // The largest quantization step of both laws is 1024 (a half step of error) plus the µ-law clipping.
+        EXPECT_LE(std::abs(decodedUlaw - sample), 1024) << sample;
+        EXPECT_LE(std::abs(decodedAlaw - sample), 1024) << sample;
+    }
+}
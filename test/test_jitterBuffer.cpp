@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include "G711.h"
+#include "JitterBuffer.h"
+#include "RtpIngest.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <future>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+    std::vector<int16_t> frame(int16_t value, std::size_t size = 4) {
+        return std::vector<int16_t>(size, value);
+    }
+
+}
+
+TEST(JitterBuffer, reorderedPacketsArePlayedInSequence) {
+    JitterBuffer buffer(60ms);
+    auto now = JitterBuffer::Clock::now();
+    std::vector<int16_t> output;
+    buffer.push(10, frame(1), now);
+    buffer.push(12, frame(3), now);
+    buffer.pop(now, output);
+    EXPECT_EQ(output, frame(1));
+    buffer.push(11, frame(2), now + 10ms);
+    buffer.pop(now + 10ms, output);
+    std::vector<int16_t> expected = frame(1);
+    for (int16_t value: {2, 3})
+        for (auto sample: frame(value))
+            expected.emplace_back(sample);
+    EXPECT_EQ(output, expected);
+    EXPECT_EQ(buffer.getStatistics().reordered, 1);
+    EXPECT_EQ(buffer.getStatistics().concealed, 0);
+}
+
+TEST(JitterBuffer, gapsAreConcealedAfterTheDelay) {
+    JitterBuffer buffer(60ms);
+    auto now = JitterBuffer::Clock::now();
+    std::vector<int16_t> output;
+    buffer.push(1, frame(1000), now);
+    buffer.push(3, frame(50), now);
+    buffer.pop(now + 59ms, output);
+    EXPECT_EQ(output.size(), 4);
+    EXPECT_EQ(buffer.nextRelease(), now + 60ms);
+    buffer.pop(now + 60ms, output);
+    ASSERT_EQ(output.size(), 12);
+    EXPECT_EQ(output[4], 750);
+    EXPECT_EQ(output[8], 50);
+    EXPECT_EQ(buffer.getStatistics().concealed, 1);
+
+    buffer.push(2, frame(2), now + 70ms);
+    EXPECT_EQ(buffer.getStatistics().late, 1);
+}
+
+TEST(JitterBuffer, sequenceNumbersWrapAround) {
+    JitterBuffer buffer(60ms);
+    auto now = JitterBuffer::Clock::now();
+    std::vector<int16_t> output;
+    buffer.push(65535, frame(1), now);
+    buffer.push(0, frame(2), now);
+    buffer.push(0, frame(2), now);
+    buffer.push(1, frame(3), now);
+    buffer.pop(now, output);
+    EXPECT_EQ(output.size(), 12);
+    EXPECT_EQ(buffer.getStatistics().duplicates, 1);
+    EXPECT_EQ(buffer.nextRelease(), JitterBuffer::Clock::time_point::max());
+}
+
+TEST(RtpIngest, flowsAreDecodedIntoLiveAudio) {
+    std::promise<std::shared_ptr<LiveAudio>> started;
+    RtpIngest ingest({0}, 20ms, 200ms, [&](const std::string &, std::shared_ptr<LiveAudio> audio) {
+        started.set_value(audio);
+    });
+    std::thread loop([&] { ingest.run(); });
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in target{};
+    target.sin_family = AF_INET;
+    target.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    target.sin_port = htons(ingest.getPorts().front());
+    std::vector<uint8_t> codes(160, g711::encodeUlaw(1000));
+    for (uint16_t sequence: {0, 2, 1, 3}) {
+        RtpPacket packet;
+        packet.sequence = sequence;
+        packet.ssrc = 1234;
+        packet.payload = codes.data();
+        packet.payloadSize = codes.size();
+        auto datagram = packet.serialize();
+        sendto(fd, datagram.data(), datagram.size(), 0, reinterpret_cast<sockaddr *>(&target), sizeof(target));
+    }
+    close(fd);
+
+    auto audio = started.get_future().get();
+    std::size_t samples = 0;
+    std::string chunk;
+    while (audio->pop(chunk))
+        samples += chunk.size() / sizeof(int16_t);
+    EXPECT_EQ(samples, 4 * codes.size());
+    ingest.stop();
+    loop.join();
+}
@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+
+#include "JobScheduler.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+
+    typedef JobScheduler::Job Job;
+
+    std::vector<std::string> pathsOf(const std::vector<Job> &jobs) {
+        std::vector<std::string> paths;
+        for (const auto &job: jobs)
+            paths.emplace_back(job.path);
+        return paths;
+    }
+
+}
+
+TEST(JobScheduler, longestFirstShortensTheMakespan) {
+    const std::vector<Job> jobs{{"a", 10s}, {"b", 10s}, {"c", 10s}, {"d", 10s}, {"long", 40s}};
+    JobScheduler scheduler(2, JobScheduler::Order::LongestFirst);
+    auto ordered = scheduler.schedule(jobs);
+    EXPECT_EQ(pathsOf(ordered), (std::vector<std::string>{"long", "a", "b", "c", "d"}));
+    EXPECT_EQ(scheduler.predictMakespan(jobs), 60s);
+    EXPECT_EQ(scheduler.predictMakespan(ordered), 40s);
+}
+
+TEST(JobScheduler, listedOrderIsKept) {
+    const std::vector<Job> jobs{{"short", 1s}, {"long", 9s}, {"unknown", 0s}};
+    JobScheduler scheduler(1, JobScheduler::Order::Listed);
+    EXPECT_EQ(pathsOf(scheduler.schedule(jobs)), (std::vector<std::string>{"short", "long", "unknown"}));
+    EXPECT_EQ(scheduler.predictMakespan(jobs), 10s);
+}
+
+TEST(JobScheduler, higherPrioritiesGoFirst) {
+    const std::vector<Job> jobs{{"low", 30s, 0}, {"urgent", 1s, 2}, {"high", 5s, 1}, {"high-long", 20s, 1}};
+    EXPECT_EQ(pathsOf(JobScheduler(2, JobScheduler::Order::LongestFirst).schedule(jobs)),
+              (std::vector<std::string>{"urgent", "high-long", "high", "low"}));
+    EXPECT_EQ(pathsOf(JobScheduler(2, JobScheduler::Order::Listed).schedule(jobs)),
+              (std::vector<std::string>{"urgent", "high", "high-long", "low"}));
+}
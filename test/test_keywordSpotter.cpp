@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include "KeywordSpotter.h"
+
+#include <sstream>
+#include <thread>
+
+using namespace speechcenter::recognizer::v1;
+
+namespace {
+
+    // Words 0.5 s apart lasting 0.3 s, all from the given speaker.
+    RecognitionResult result(const std::string &transcript, bool final, uint32_t speaker = 0) {
+        RecognitionResult result;
+        result.set_is_final(final);
+        auto alternative = result.add_alternatives();
+        alternative->set_transcript(transcript);
+        std::istringstream words(transcript);
+        std::string text;
+        for (int i = 0; words >> text; ++i) {
+            auto word = alternative->add_words();
+            word->set_word(text);
+            word->set_start_time(i * 0.5f);
+            word->set_end_time(i * 0.5f + 0.3f);
+            word->set_speaker_id(speaker);
+        }
+        return result;
+    }
+
+    struct Spotted {
+        explicit Spotted(std::vector<std::string> phrases) :
+                automaton(std::make_shared<const KeywordAutomaton>(phrases)),
+                spotter(automaton, [this](const KeywordSpotter::Hit &hit) { hits.push_back(hit); }) {}
+
+        std::shared_ptr<const KeywordAutomaton> automaton;
+        std::vector<KeywordSpotter::Hit> hits;
+        KeywordSpotter spotter;
+    };
+
+}
+
+TEST(KeywordAutomaton, tokenizeFoldsCaseAccentsAndPunctuation) {
+    std::vector<std::string> expected{"cancelar", "la", "peticion", "l", "avi", "strasse", "senal", "istanbul"};
+    EXPECT_EQ(KeywordAutomaton::tokenize("¿CANCELAR la Petición? L’avi, Straße... señal İstanbul"), expected);
+    EXPECT_TRUE(KeywordAutomaton::tokenize(" ¡! ").empty());
+}
+
+TEST(KeywordAutomaton, mergesPhrasesWithTheSameWords) {
+    KeywordAutomaton automaton({"Baja del servicio", "baja del SERVICIO.", "", "..."});
+    EXPECT_EQ(automaton.countPhrases(), 1);
+    EXPECT_EQ(automaton.getLength(0), 3);
+}
+
+TEST(KeywordSpotter, findsOverlappingPhrasesAsWholeWords) {
+    Spotted spotted({"cuenta", "cuenta bancaria", "bancaria fraudulenta", "ban"});
+    spotted.spotter.onResult(result("mi cuenta bancaria fraudulenta", true, 2));
+    ASSERT_EQ(spotted.hits.size(), 3);
+    EXPECT_EQ(spotted.hits[0].phrase, "cuenta");
+    EXPECT_EQ(spotted.hits[1].phrase, "cuenta bancaria");
+    EXPECT_FLOAT_EQ(spotted.hits[1].startTime, 0.5);
+    EXPECT_FLOAT_EQ(spotted.hits[1].endTime, 1.3);
+    EXPECT_EQ(spotted.hits[2].phrase, "bancaria fraudulenta");
+    EXPECT_EQ(spotted.hits[2].speaker, 2);
+    EXPECT_TRUE(spotted.hits[2].final);
+}
+
+TEST(KeywordSpotter, followsFailuresAfterAPartialMatch) {
+    Spotted spotted({"a b c d", "b c e"});
+    spotted.spotter.onResult(result("a b c e", true));
+    ASSERT_EQ(spotted.hits.size(), 1);
+    EXPECT_EQ(spotted.hits[0].phrase, "b c e");
+    EXPECT_FLOAT_EQ(spotted.hits[0].startTime, 0.5);
+}
+
+TEST(KeywordSpotter, reportsOnceWhileInterimResultsAreRevised) {
+    Spotted spotted({"hablar con un abogado"});
+    spotted.spotter.onResult(result("quiero hablar", false));
+    spotted.spotter.onResult(result("quiero hablar con un abogado", false));
+    spotted.spotter.onResult(result("quiero hablar con un abogado ya", false));
+    spotted.spotter.onResult(result("quiero hablar con un abogado ya", true));
+    ASSERT_EQ(spotted.hits.size(), 1);
+    EXPECT_FALSE(spotted.hits[0].final);
+
+    // A revision with a second occurrence reports only the new one.
+    spotted.spotter.onResult(result("hablar con un abogado", false));
+    spotted.spotter.onResult(result("hablar con un abogado o hablar con un abogado", true));
+    ASSERT_EQ(spotted.hits.size(), 3);
+    EXPECT_FALSE(spotted.hits[1].final);
+    EXPECT_TRUE(spotted.hits[2].final);
+    EXPECT_FLOAT_EQ(spotted.hits[2].startTime, 2.5);
+}
+
+TEST(KeywordSpotter, matchesTheTranscriptWithoutWordTimings) {
+    Spotted spotted({"darse de baja"});
+    RecognitionResult interim;
+    interim.add_alternatives()->set_transcript("Quiero DARSE de baja.");
+    spotted.spotter.onResult(interim);
+    ASSERT_EQ(spotted.hits.size(), 1);
+    EXPECT_EQ(spotted.hits[0].startTime, 0);
+}
+
+TEST(KeywordSpotter, sharesOneAutomatonBetweenStreams) {
+    std::vector<std::string> phrases;
+    for (int i = 0; i < 5000; ++i)
+        phrases.push_back("frase " + std::to_string(i));
+    auto automaton = std::make_shared<const KeywordAutomaton>(phrases);
+    EXPECT_EQ(automaton->countPhrases(), 5000);
+
+    std::vector<std::size_t> hits(4);
+    std::vector<std::thread> streams;
+    for (std::size_t stream = 0; stream < hits.size(); ++stream)
+        streams.emplace_back([&, stream] {
+            KeywordSpotter spotter(automaton, [&, stream](const KeywordSpotter::Hit &) { ++hits[stream]; });
+            for (int i = 0; i < 1000; ++i)
+                spotter.onResult(result("la frase " + std::to_string(i * 5) + " y frase", true));
+        });
+    for (auto &stream: streams)
+        stream.join();
+    EXPECT_EQ(hits, std::vector<std::size_t>(4, 1000));
+}
@@ -0,0 +1,36 @@
+#include <gtest/gtest.h>
+
+#include "SessionCapture.h"
+
+#include <cstdio>
+
+using namespace speechcenter::recognizer::v1;
+
+TEST(SessionCapture, recordedSessionIsReadBackInOrder) {
+    const std::string path = "test_session.capture";
+    {
+        SessionRecorder recorder(path);
+        RecognitionStreamingRequest config;
+        config.mutable_config()->mutable_parameters()->set_language("es");
+        recorder.record(config);
+        RecognitionStreamingRequest audio;
+        audio.set_audio(std::string(3200, '\x01'));
+        recorder.record(audio);
+        RecognitionStreamingResponse response;
+        response.mutable_result()->set_is_final(true);
+        response.mutable_result()->add_alternatives()->set_transcript("hola");
+        recorder.record(response);
+    }
+
+    SessionCapture capture(path);
+    std::remove(path.c_str());
+    const auto &records = capture.getRecords();
+    ASSERT_EQ(records.size(), 3);
+    EXPECT_EQ(capture.countRequests(), 2);
+    EXPECT_EQ(capture.countResponses(), 1);
+    EXPECT_EQ(records[0].request().config().parameters().language(), "es");
+    EXPECT_EQ(records[1].request().audio().size(), 3200);
+    EXPECT_EQ(records[2].response().result().alternatives(0).transcript(), "hola");
+    EXPECT_LE(records[0].timestamp_us(), records[1].timestamp_us());
+    EXPECT_LE(records[1].timestamp_us(), records[2].timestamp_us());
+}
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+
+#include "SharedQuota.h"
+
+#include <thread>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+    // A fresh object per test, removed again afterwards.
+    class SharedQuotaTest : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            name = "/test_shared_quota." + std::to_string(getpid()) + "." +
+                   ::testing::UnitTest::GetInstance()->current_test_info()->name();
+            shm_unlink(name.c_str());
+        }
+
+        void TearDown() override {
+            shm_unlink(name.c_str());
+        }
+
+        std::string name;
+    };
+
+    const SharedQuota::Waiter giveUp = [](std::chrono::milliseconds) { return false; };
+
+}
+
+TEST_F(SharedQuotaTest, streamsAreLimitedAcrossInstances) {
+    SharedQuota first(name, {2, 0});
+    SharedQuota second(name, {5, 0});
+    EXPECT_EQ(second.getLimits().streams, 2);
+    auto a = first.acquireStream(giveUp);
+    auto b = second.acquireStream(giveUp);
+    ASSERT_TRUE(a);
+    ASSERT_TRUE(b);
+    EXPECT_FALSE(second.acquireStream(giveUp));
+    b.release();
+    EXPECT_TRUE(first.acquireStream(giveUp));
+}
+
+TEST_F(SharedQuotaTest, waiterIsCalledUntilAStreamIsFree) {
+    SharedQuota quota(name, {1, 0});
+    auto held = quota.acquireStream(giveUp);
+    int waits = 0;
+    auto next = quota.acquireStream([&](std::chrono::milliseconds) {
+        if (++waits == 3)
+            held.release();
+        return true;
+    });
+    EXPECT_TRUE(next);
+    EXPECT_EQ(waits, 3);
+}
+
+TEST_F(SharedQuotaTest, slotsOfExitedProcessesAreReclaimed) {
+    SharedQuota quota(name, {1, 0});
+    const pid_t child = fork();
+    if (child == 0) {
+        SharedQuota inChild(name, {1, 0});
+        auto lease = inChild.acquireStream(giveUp);
+        // Exits without running destructors, like a crash.
+        _exit(lease ? 0 : 1);
+    }
+    int status = 0;
+    ASSERT_EQ(waitpid(child, &status, 0), child);
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+    EXPECT_TRUE(quota.acquireStream(giveUp));
+}
+
+TEST_F(SharedQuotaTest, audioIsPacedToTheRate) {
+    SharedQuota quota(name, {0, 100});
+    // A burst of schedule is let through right away, 100 s of audio is 1 s at this rate.
+    for (int i = 0; i < 10; ++i)
+        EXPECT_TRUE(quota.acquireAudio(100s, giveUp));
+    EXPECT_TRUE(quota.acquireAudio(100s, giveUp));
+    EXPECT_FALSE(quota.acquireAudio(100s, giveUp));
+    std::chrono::milliseconds waited{0};
+    EXPECT_TRUE(quota.acquireAudio(100s, [&waited](std::chrono::milliseconds duration) {
+        waited += duration;
+        std::this_thread::sleep_for(duration);
+        return true;
+    }));
+    EXPECT_GT(waited, 500ms);
+    EXPECT_LE(waited, 1200ms);
+}
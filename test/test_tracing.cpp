@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+
+#include "AudioPrefetcher.h"
+#include "Configuration.h"
+#include "RecognitionClient.h"
+#include "Tracing.h"
+
+#include "sndfile.hh"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+    std::string writeAndRead(const TraceSession &trace) {
+        const std::string path = "test_trace.json";
+        trace.write(path);
+        std::ifstream input(path);
+        std::stringstream content;
+        content << input.rdbuf();
+        std::remove(path.c_str());
+        return content.str();
+    }
+
+}
+
+TEST(Tracing, audioPreparationReachesTheSessionTrace) {
+    if (!tracingEnabled)
+        GTEST_SKIP() << "Built without ENABLE_TRACING";
+    const std::string path = "test_trace.wav";
+    {
+        std::vector<int16_t> samples(8000, 100);
+        SndfileHandle file(path, SFM_WRITE, SF_FORMAT_WAV | SF_FORMAT_PCM_16, 1, 8000);
+        ASSERT_EQ(file.write(samples.data(), static_cast<sf_count_t>(samples.size())), 8000);
+    }
+    // Decoded on the prefetcher thread and chunked on this one, both without a session bound.
+    auto audio = AudioPrefetcher({path}, 1).next();
+    std::remove(path.c_str());
+    auto requests = RecognitionClient::prepareAudio(audio);
+
+    // As a session does when it runs.
+    TraceSession session;
+    session.merge(requests->trace);
+    const auto trace = writeAndRead(session);
+    EXPECT_NE(trace.find(R"("name":"Audio::decode")"), std::string::npos);
+    EXPECT_NE(trace.find(R"("name":"buildAudioRequests")"), std::string::npos);
+}
+
+TEST(Tracing, grammarReadWhileParsingIsKept) {
+    if (!tracingEnabled)
+        GTEST_SKIP() << "Built without ENABLE_TRACING";
+    const std::string grammar = "test_grammar.tar.xz";
+    std::ofstream(grammar) << "grammar";
+    const char *argv[] = {"cli_client", "-a", "file.wav", "-C", grammar.c_str(), "-A", "V2"};
+    Configuration configuration(sizeof(argv) / sizeof(argv[0]), const_cast<char **>(argv));
+    std::remove(grammar.c_str());
+
+    // The client merges it into its setup trace, which goes into the trace of its first session.
+    TraceSession session;
+    session.merge(Configuration(configuration).getParseTrace());
+    EXPECT_NE(writeAndRead(session).find(R"("name":"Grammar::readCompiledGrammar")"), std::string::npos);
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include "TranscriptCache.h"
+
+#include <filesystem>
+
+using namespace speechcenter::recognizer::v1;
+
+namespace {
+
+    RecognitionResult finalResult(const std::string &transcript) {
+        RecognitionResult result;
+        result.set_is_final(true);
+        result.add_alternatives()->set_transcript(transcript);
+        return result;
+    }
+
+}
+
+TEST(TranscriptCache, storedResultsAreFoundAcrossInstances) {
+    const std::string directory = "test_transcript_cache";
+    std::filesystem::remove_all(directory);
+    {
+        TranscriptCache cache(directory);
+        std::vector<RecognitionResult> results;
+        EXPECT_FALSE(cache.lookup(42, results));
+        cache.store(42, {finalResult("hello"), finalResult("world")});
+        ASSERT_TRUE(cache.lookup(42, results));
+        ASSERT_EQ(results.size(), 2);
+        EXPECT_EQ(results[1].alternatives(0).transcript(), "world");
+    }
+    TranscriptCache reopened(directory);
+    std::vector<RecognitionResult> results;
+    reopened.store(42, {finalResult("updated")});
+    ASSERT_TRUE(reopened.lookup(42, results));
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results[0].alternatives(0).transcript(), "updated");
+    std::filesystem::remove_all(directory);
+}
+
+TEST(TranscriptCache, noResultsAreNotStored) {
+    const std::string directory = "test_transcript_cache_empty";
+    std::filesystem::remove_all(directory);
+    TranscriptCache cache(directory);
+    cache.store(7, {});
+    std::vector<RecognitionResult> results;
+    EXPECT_FALSE(cache.lookup(7, results));
+    cache.store(7, {finalResult("later")});
+    ASSERT_TRUE(cache.lookup(7, results));
+    EXPECT_EQ(results[0].alternatives(0).transcript(), "later");
+    std::filesystem::remove_all(directory);
+}
+
+TEST(TranscriptCache, hashDependsOnEveryByteAndSeed) {
+    std::vector<int16_t> samples(1001, 3);
+    const auto reference = TranscriptCache::hash(samples.data(), samples.size() * 2, 8000);
+    EXPECT_EQ(reference, TranscriptCache::hash(samples.data(), samples.size() * 2, 8000));
+    EXPECT_NE(reference, TranscriptCache::hash(samples.data(), samples.size() * 2, 16000));
+    samples.back() = 4;
+    EXPECT_NE(reference, TranscriptCache::hash(samples.data(), samples.size() * 2, 8000));
+}
+
+TEST(TranscriptCache, indexGrowsAndIsFollowedByOtherInstances) {
+    const std::string directory = "test_transcript_cache_growth";
+    std::filesystem::remove_all(directory);
+    TranscriptCache writer(directory), reader(directory);
+    std::vector<RecognitionResult> results;
+    // Keys with equal low bits probe the same run of slots, and enough of them to double the table twice.
+    for (uint64_t i = 0; i < 3000; ++i)
+        writer.store(i << 20, {finalResult(std::to_string(i))});
+    writer.store(0, {finalResult("zero")});
+    for (uint64_t i = 0; i < 3000; i += 7) {
+        ASSERT_TRUE(reader.lookup(i << 20, results)) << i;
+        EXPECT_EQ(results[0].alternatives(0).transcript(), i ? std::to_string(i) : "zero");
+    }
+    EXPECT_FALSE(reader.lookup(3000 << 20, results));
+    EXPECT_FALSE(reader.lookup(2, results));
+    std::filesystem::remove_all(directory);
+}
+
+TEST(TranscriptCache, invalidIndexIsReplacedWithAnEmptyOne) {
+    const std::string directory = "test_transcript_cache_invalid";
+    std::filesystem::remove_all(directory);
+    {
+        TranscriptCache cache(directory);
+        cache.store(42, {finalResult("hello")});
+    }
+    std::filesystem::resize_file(directory + "/transcripts.index", 100);
+    TranscriptCache reopened(directory);
+    std::vector<RecognitionResult> results;
+    EXPECT_FALSE(reopened.lookup(42, results));
+    reopened.store(42, {finalResult("again")});
+    ASSERT_TRUE(reopened.lookup(42, results));
+    EXPECT_EQ(results[0].alternatives(0).transcript(), "again");
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include "TranscriptStore.h"
+#include "gRpcExceptions.h"
+
+#include <fstream>
+
+using namespace speechcenter::recognizer::v1;
+
+namespace {
+
+    // One word every 0.5 s lasting 0.3 s, cycling through a few terms, with a speaker change every 100 words.
+    RecognitionResult finalResult(int firstWord, int words) {
+        static const std::vector<std::string> vocabulary{"hola", "buenos", "días", "cuenta", "saldo", "gracias"};
+        RecognitionResult result;
+        result.set_is_final(true);
+        auto alternative = result.add_alternatives();
+        for (int i = firstWord; i < firstWord + words; ++i) {
+            auto word = alternative->add_words();
+            word->set_word(vocabulary[i % vocabulary.size()]);
+            word->set_start_time(i * 0.5f);
+            word->set_end_time(i * 0.5f + 0.3f);
+            word->set_confidence(i % 2 ? 0.5f : 1.0f);
+            word->set_speaker_id(i / 100 % 2);
+        }
+        return result;
+    }
+
+    const std::string path = "test_transcript.sct";
+
+    void writeTranscript(int words) {
+        TranscriptWriter writer;
+        RecognitionResult interim = finalResult(0, 3);
+        interim.set_is_final(false);
+        writer.add(interim);
+        for (int first = 0; first < words; first += 50)
+            writer.add(finalResult(first, std::min(50, words - first)));
+        EXPECT_EQ(writer.countWords(), words);
+        writer.write(path);
+    }
+
+}
+
+TEST(TranscriptStore, wordsBetweenTwoTimes) {
+    writeTranscript(1000);
+    TranscriptReader reader(path);
+    ASSERT_EQ(reader.countWords(), 1000);
+    auto words = reader.between(100.2, 102.0);
+    ASSERT_EQ(words.size(), 5);
+    EXPECT_EQ(words[0].index, 200);
+    EXPECT_EQ(words[0].text, "días");
+    EXPECT_DOUBLE_EQ(words[0].startTime, 100.0);
+    EXPECT_DOUBLE_EQ(words[0].endTime, 100.3);
+    EXPECT_EQ(words[0].speaker, 0);
+    EXPECT_FLOAT_EQ(words[0].confidence, 1.0f);
+    EXPECT_EQ(words[3].index, 203);
+    EXPECT_NEAR(words[3].confidence, 0.5f, 0.01f);
+    EXPECT_EQ(words[4].index, 204);
+    EXPECT_EQ(reader.between(50.0, 50.1).front().speaker, 1);
+    EXPECT_EQ(reader.between(0, 1000).size(), 1000);
+    EXPECT_TRUE(reader.between(600, 700).empty());
+}
+
+TEST(TranscriptStore, allOccurrencesOfATerm) {
+    writeTranscript(1000);
+    TranscriptReader reader(path);
+    auto words = reader.find("saldo");
+    ASSERT_EQ(words.size(), 166);
+    for (const auto &word: words) {
+        EXPECT_EQ(word.index % 6, 4);
+        EXPECT_DOUBLE_EQ(word.startTime, word.index * 0.5);
+        EXPECT_EQ(word.speaker, word.index / 100 % 2);
+    }
+    EXPECT_TRUE(reader.find("adiós").empty());
+    EXPECT_TRUE(reader.find("sald").empty());
+}
+
+TEST(TranscriptStore, emptyTranscript) {
+    writeTranscript(0);
+    TranscriptReader reader(path);
+    EXPECT_EQ(reader.countWords(), 0);
+    EXPECT_TRUE(reader.between(0, 10).empty());
+    EXPECT_TRUE(reader.find("hola").empty());
+}
+
+TEST(TranscriptStore, otherFilesAreRejected) {
+    std::ofstream(path, std::ios::trunc) << std::string(200, 'x');
+    EXPECT_THROW(TranscriptReader reader(path), IOError);
+}
+
+TEST(TranscriptStore, skipIndexOutsideTheColumnsIsRejected) {
+    writeTranscript(1000);
+    transcript::Header header{};
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    transcript::Block block{};
+    const auto last = static_cast<std::streamoff>(header.blockIndex + (header.blocks - 1) * sizeof(block));
+    file.seekg(last);
+    file.read(reinterpret_cast<char *>(&block), sizeof(block));
+    block.starts = static_cast<uint32_t>(header.ends - header.starts);
+    file.seekp(last);
+    file.write(reinterpret_cast<const char *>(&block), sizeof(block));
+    file.close();
+    EXPECT_THROW(TranscriptReader reader(path), IOError);
+}
@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+
+#include "TranscriptTimeline.h"
+
+#include <sstream>
+
+using namespace speechcenter::recognizer::v1;
+
+namespace {
+
+    // Words 0.5 s apart from the given time on.
+    RecognitionResult result(const std::string &transcript, bool final, float start = 0) {
+        RecognitionResult result;
+        result.set_is_final(final);
+        auto alternative = result.add_alternatives();
+        alternative->set_transcript(transcript);
+        std::istringstream words(transcript);
+        std::string text;
+        for (int i = 0; words >> text; ++i) {
+            auto word = alternative->add_words();
+            word->set_word(text);
+            word->set_start_time(start + i * 0.5f);
+            word->set_end_time(start + i * 0.5f + 0.3f);
+        }
+        return result;
+    }
+
+    struct Change {
+        std::size_t first;
+        std::size_t removed;
+        std::string inserted;
+        bool final;
+
+        bool operator==(const Change &other) const = default;
+    };
+
+    std::ostream &operator<<(std::ostream &out, const Change &change) {
+        return out << change.first << "-" << change.removed << " '" << change.inserted << "'"
+                   << (change.final ? " final" : "");
+    }
+
+    struct Subscribed {
+        Subscribed() {
+            timeline.subscribe([this](const TranscriptTimeline::Diff &diff) {
+                std::string inserted;
+                for (const auto &word: diff.inserted)
+                    inserted += (inserted.empty() ? "" : " ") + word.text;
+                changes.push_back({diff.first, diff.removed, inserted, diff.final});
+            });
+        }
+
+        TranscriptTimeline timeline;
+        std::vector<Change> changes;
+    };
+
+}
+
+TEST(TranscriptTimeline, sendsOnlyTheWordsAddedToTheTail) {
+    Subscribed subscribed;
+    subscribed.timeline.apply(result("quiero", false));
+    subscribed.timeline.apply(result("quiero consultar", false));
+    subscribed.timeline.apply(result("quiero consultar mi saldo", false));
+    std::vector<Change> expected{{0, 0, "quiero", false}, {1, 0, "consultar", false}, {2, 0, "mi saldo", false}};
+    EXPECT_EQ(subscribed.changes, expected);
+    EXPECT_EQ(subscribed.timeline.text(), "quiero consultar mi saldo");
+    EXPECT_EQ(subscribed.timeline.countFrozen(), 0);
+}
+
+TEST(TranscriptTimeline, replacesOnlyTheRevisedWords) {
+    Subscribed subscribed;
+    subscribed.timeline.apply(result("quiero consultar mi sal do por favor", false));
+    subscribed.timeline.apply(result("quiero consultar mi saldo ya por favor", false));
+    subscribed.timeline.apply(result("quiero consultar mi saldo", false));
+    ASSERT_EQ(subscribed.changes.size(), 3);
+    EXPECT_EQ(subscribed.changes[1], (Change{3, 2, "saldo ya", false}));
+    EXPECT_EQ(subscribed.changes[2], (Change{4, 3, "", false}));
+    EXPECT_EQ(subscribed.timeline.text(), "quiero consultar mi saldo");
+}
+
+TEST(TranscriptTimeline, freezesFinalSegments) {
+    Subscribed subscribed;
+    subscribed.timeline.apply(result("buenos días", false));
+    subscribed.timeline.apply(result("buenos días", true));
+    subscribed.timeline.apply(result("en qué", false, 2));
+    subscribed.timeline.apply(result("le puedo", false, 2));
+    subscribed.timeline.apply(result("en qué le puedo ayudar", true, 2));
+    std::vector<Change> expected{{0, 0, "buenos días", false}, {2, 0, "", true}, {2, 0, "en qué", false},
+                                 {2, 2, "le puedo", false}, {2, 2, "en qué le puedo ayudar", true}};
+    EXPECT_EQ(subscribed.changes, expected);
+    EXPECT_EQ(subscribed.timeline.countFrozen(), 7);
+    EXPECT_EQ(subscribed.timeline.text(2), "en qué le puedo ayudar");
+    EXPECT_FLOAT_EQ(subscribed.timeline.getWords()[6].startTime, 4);
+}
+
+TEST(TranscriptTimeline, revisesTimingsAndEmptiesTheTail) {
+    Subscribed subscribed;
+    subscribed.timeline.apply(result("hola", true));
+    subscribed.timeline.apply(result("adiós", false, 1));
+    subscribed.timeline.apply(result("adiós", false, 1.2f));
+    EXPECT_FLOAT_EQ(subscribed.timeline.getWords()[1].startTime, 1.2f);
+    subscribed.timeline.apply(result("", false));
+    subscribed.timeline.apply(result("", false));
+    std::vector<Change> expected{{0, 0, "hola", true}, {1, 0, "adiós", false}, {2, 0, "", false},
+                                 {1, 1, "", false}};
+    EXPECT_EQ(subscribed.changes, expected);
+    EXPECT_EQ(subscribed.timeline.text(), "hola");
+}
+
+TEST(TranscriptTimeline, rescoresWordsInPlace) {
+    Subscribed subscribed;
+    subscribed.timeline.apply(result("quiero consultar mi saldo", false));
+    auto rescored = result("quiero consultar mi saldo", false);
+    rescored.mutable_alternatives(0)->mutable_words(3)->set_confidence(0.9f);
+    rescored.mutable_alternatives(0)->mutable_words(3)->set_speaker_id(2);
+    subscribed.timeline.apply(rescored);
+    subscribed.timeline.apply(rescored);
+    std::vector<Change> expected{{0, 0, "quiero consultar mi saldo", false}, {4, 0, "", false}};
+    EXPECT_EQ(subscribed.changes, expected);
+    const auto &saldo = subscribed.timeline.getWords()[3];
+    EXPECT_FLOAT_EQ(saldo.confidence, 0.9f);
+    EXPECT_EQ(saldo.speaker, 2);
+}
+
+TEST(TranscriptTimeline, usesTheTranscriptWithoutWordTimings) {
+    Subscribed subscribed;
+    RecognitionResult interim;
+    interim.add_alternatives()->set_transcript("  sin   tiempos ");
+    subscribed.timeline.apply(interim);
+    EXPECT_EQ(subscribed.changes, std::vector<Change>{(Change{0, 0, "sin tiempos", false})});
+    RecognitionResult empty;
+    subscribed.timeline.apply(empty);
+    EXPECT_EQ(subscribed.changes.back(), (Change{0, 2, "", false}));
+}
+
+TEST(TranscriptTimeline, revisionCostFollowsTheTail) {
+    TranscriptTimeline timeline;
+    std::size_t inserted = 0;
+    timeline.subscribe([&](const TranscriptTimeline::Diff &diff) { inserted += diff.inserted.size(); });
+    std::string segment = "una frase de ocho palabras para cada segmento";
+    for (int i = 0; i < 2000; ++i) {
+        timeline.apply(result("una frase de", false, i * 5.0f));
+        timeline.apply(result(segment, false, i * 5.0f));
+        timeline.apply(result(segment, true, i * 5.0f));
+    }
+    EXPECT_EQ(timeline.countFrozen(), 16000);
+    // Three words, then the five that follow them, for every segment.
+    EXPECT_EQ(inserted, 2000 * 8);
+}
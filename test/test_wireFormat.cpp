@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include "WireFormat.h"
+
+using namespace speechcenter::recognizer::v1;
+
+namespace {
+
+    std::string flatten(const grpc::ByteBuffer &buffer) {
+        std::vector<grpc::Slice> slices;
+        EXPECT_TRUE(buffer.Dump(&slices).ok());
+        std::string bytes;
+        for (const auto &slice: slices)
+            bytes.append(reinterpret_cast<const char *>(slice.begin()), slice.size());
+        return bytes;
+    }
+
+}
+
+TEST(WireFormat, audioFramesMatchTheProtobufEncoding) {
+    for (std::size_t length: {0, 1, 127, 128, 16383, 16384, 40000}) {
+        auto samples = std::make_shared<std::string>(length, '\0');
+        for (std::size_t i = 0; i < length; ++i)
+            (*samples)[i] = static_cast<char>(i * 7);
+        RecognitionStreamingRequest request;
+        request.set_audio(*samples);
+        const auto expected = request.SerializeAsString();
+
+        auto referenced = wire::audioFrame(samples->data(), samples->size(), samples);
+        EXPECT_EQ(flatten(referenced.buffer), expected) << length;
+        EXPECT_EQ(referenced.audioBytes, length);
+        auto moved = wire::audioFrame(std::string(*samples));
+        EXPECT_EQ(flatten(moved.buffer), expected) << length;
+        EXPECT_EQ(flatten(wire::serialize(request).buffer), expected) << length;
+    }
+}
+
+TEST(WireFormat, framesKeepTheirAudioAlive) {
+    auto samples = std::make_shared<std::string>(100, 'x');
+    std::weak_ptr<std::string> watch = samples;
+    auto frame = wire::audioFrame(samples->data(), samples->size(), samples);
+    samples.reset();
+    grpc::ByteBuffer copy(frame.buffer);
+    frame = {};
+    EXPECT_FALSE(watch.expired());
+    RecognitionStreamingRequest request;
+    ASSERT_TRUE(wire::parse(copy, request));
+    EXPECT_EQ(request.audio(), std::string(100, 'x'));
+    copy.Clear();
+    EXPECT_TRUE(watch.expired());
+}
+
+TEST(WireFormat, responsesAreParsed) {
+    RecognitionStreamingResponse response;
+    response.mutable_result()->add_alternatives()->set_transcript("hola");
+    const auto serialized = response.SerializeAsString();
+    grpc::Slice slice(serialized.data(), serialized.size());
+    grpc::ByteBuffer buffer(&slice, 1);
+    RecognitionStreamingResponse parsed;
+    ASSERT_TRUE(wire::parse(buffer, parsed));
+    EXPECT_EQ(parsed.result().alternatives(0).transcript(), "hola");
+}